@@ -0,0 +1,192 @@
+// AdaptiveRenderer.cpp
+// ---------------------------------------------------------
+// Round-based adaptive sampling (see AdaptiveRenderer.hpp)
+// ---------------------------------------------------------
+
+#include "AdaptiveRenderer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+#include "ThreadPool.hpp"
+
+namespace {
+
+struct WorkItem {
+    int tile;
+    int y0;         // Block row inside the tile
+    int samples;    // Samples to add to every pixel of the row
+};
+
+} // namespace
+
+AdaptiveStats AdaptiveRenderer::render(const RayTracer& tracer, const Camera& camera, const RenderSettings& settings,
+                                       const AdaptiveSettings& adaptive) {
+    const int width = std::max(settings.width, 1);
+    const int height = std::max(settings.height, 1);
+    const int tileSize = std::max(settings.tileSize, 1);
+    minSamples = std::max(adaptive.minSamples, 2);      // Variance needs two samples
+    maxSamples = std::max(adaptive.maxSamples, minSamples);
+    // At most minSamples, so the smallest increment never exceeds the doubling cap
+    const int samplesPerRound = std::clamp(adaptive.samplesPerRound, 1, minSamples);
+    const float threshold = std::max(adaptive.threshold, 0.0f);
+
+    mean.resize(width, height);
+    luminanceMean.assign(mean.pixels.size(), 0.0f);
+    luminanceM2.assign(mean.pixels.size(), 0.0f);
+    tiles.clear();
+    for (int y = 0; y < height; y += tileSize) {
+        for (int x = 0; x < width; x += tileSize) {
+            Tile tile;
+            tile.rect = { x, y, std::min(x + tileSize, width), std::min(y + tileSize, height) };
+            tiles.push_back(tile);
+        }
+    }
+
+    // Every sample is jittered; the jitter hash continues per pixel across rounds
+    RenderSettings sampleSettings = settings;
+    sampleSettings.samplesPerPixel = maxSamples;
+    sampleSettings.firstSample = 0;
+
+    const CameraRays cameraRays(camera, width, height);
+    std::atomic<uint64_t> primaryRays{0};
+    std::atomic<uint64_t> shadowRays{0};
+    Noise::ThreadPool& pool = Noise::ThreadPool::global();
+    AdaptiveStats stats;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<WorkItem> items;
+    std::vector<int> active;
+    for (;;) {
+        // -----------------------------
+        // Plan the round: noisy tiles ask for n * (error / threshold)^2 samples
+        // in total, since the standard error falls with 1 / sqrt(n)
+        // -----------------------------
+        items.clear();
+        active.clear();
+        for (int t = 0; t < static_cast<int>(tiles.size()); ++t) {
+            Tile& tile = tiles[t];
+            if (tile.done)
+                continue;
+            int add = minSamples;
+            if (tile.samples > 0) {
+                const double ratio = static_cast<double>(tile.error) / std::max(threshold, 1e-12f);
+                const double needed = std::ceil(tile.samples * ratio * ratio) - tile.samples;
+                add = static_cast<int>(std::clamp(needed, static_cast<double>(samplesPerRound),
+                                                  static_cast<double>(tile.samples)));
+            }
+            add = std::min(add, maxSamples - tile.samples);
+            active.push_back(t);
+            for (int y = tile.rect.y0; y < tile.rect.y1; y += RayTracer::blockHeight)
+                items.push_back({ t, y, add });
+        }
+        if (active.empty())
+            break;
+        ++stats.rounds;
+
+        // -----------------------------
+        // Trace: one pool task per tile block-row
+        // -----------------------------
+        pool.parallel_for(items.size(), [&](size_t i) {
+            const WorkItem& item = items[i];
+            const Tile& tile = tiles[item.tile];
+            uint64_t itemShadowRays = 0;
+            std::vector<glm::vec3> colors(static_cast<size_t>(item.samples) * packetWidth);
+            std::vector<float> weights(static_cast<size_t>(item.samples));    // 1 / n after each sample
+            for (int s = 0; s < item.samples; ++s)
+                weights[s] = 1.0f / static_cast<float>(tile.samples + s + 1);
+            for (int x0 = tile.rect.x0; x0 < tile.rect.x1; x0 += RayTracer::blockWidth) {
+                const uint32_t lanes = tracer.sampleBlock(cameraRays, sampleSettings, tile.rect, x0, item.y0,
+                                                          static_cast<uint32_t>(tile.samples), item.samples,
+                                                          colors.data(), itemShadowRays);
+                for (int lane = 0; lane < packetWidth; ++lane) {
+                    if (!(lanes & (1u << lane)))
+                        continue;
+                    const size_t p = static_cast<size_t>(item.y0 + lane / RayTracer::blockWidth) * width
+                                   + static_cast<size_t>(x0 + lane % RayTracer::blockWidth);
+                    for (int s = 0; s < item.samples; ++s) {
+                        const glm::vec3& c = colors[static_cast<size_t>(s) * packetWidth + lane];
+                        mean.pixels[p] += (c - mean.pixels[p]) * weights[s];
+                        const float l = luminance(c);
+                        const float delta = l - luminanceMean[p];
+                        luminanceMean[p] += delta * weights[s];
+                        luminanceM2[p] += delta * (l - luminanceMean[p]);
+                    }
+                }
+            }
+            const int rows = std::min(RayTracer::blockHeight, tile.rect.y1 - item.y0);
+            primaryRays.fetch_add(static_cast<uint64_t>(item.samples) * rows * (tile.rect.x1 - tile.rect.x0),
+                                  std::memory_order_relaxed);
+            shadowRays.fetch_add(itemShadowRays, std::memory_order_relaxed);
+        });
+
+        // -----------------------------
+        // Tile error: RMS over its pixels of the standard error of the mean,
+        // sqrt(variance / n) with the unbiased variance M2 / (n - 1)
+        // -----------------------------
+        for (const WorkItem& item : items) {
+            Tile& tile = tiles[item.tile];
+            if (item.y0 == tile.rect.y0)
+                tile.samples += item.samples;
+        }
+        pool.parallel_for(active.size(), [&](size_t i) {
+            Tile& tile = tiles[active[i]];
+            const double n = static_cast<double>(tile.samples);
+            double sum = 0.0;
+            for (int y = tile.rect.y0; y < tile.rect.y1; ++y) {
+                for (int x = tile.rect.x0; x < tile.rect.x1; ++x)
+                    sum += luminanceM2[static_cast<size_t>(y) * width + x];
+            }
+            const double pixels = static_cast<double>(tile.rect.x1 - tile.rect.x0) * (tile.rect.y1 - tile.rect.y0);
+            tile.error = static_cast<float>(std::sqrt(sum / (pixels * (n - 1.0) * n)));
+            tile.done = tile.error <= threshold || tile.samples >= maxSamples;
+        });
+    }
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.primaryRays = primaryRays.load();
+    stats.shadowRays = shadowRays.load();
+    stats.threads = Noise::thread_count();
+    stats.tiles = static_cast<int>(tiles.size());
+
+    double errorSquared = 0.0;
+    for (const Tile& tile : tiles) {
+        const double pixels = static_cast<double>(tile.rect.x1 - tile.rect.x0) * (tile.rect.y1 - tile.rect.y0);
+        if (tile.error <= threshold)
+            ++stats.convergedTiles;
+        errorSquared += static_cast<double>(tile.error) * tile.error * pixels;
+    }
+    const double pixels = static_cast<double>(width) * height;
+    stats.meanSamples = static_cast<double>(stats.primaryRays) / pixels;
+    stats.estimatedError = static_cast<float>(std::sqrt(errorSquared / pixels));
+    return stats;
+}
+
+Framebuffer AdaptiveRenderer::sampleHeatmap() const {
+    Framebuffer heatmap(mean.width, mean.height);
+    // Log scale: adaptive rounds grow sample counts geometrically
+    const float range = std::log2(static_cast<float>(maxSamples) / minSamples);
+    for (const Tile& tile : tiles) {
+        const float octaves = std::log2(static_cast<float>(std::max(tile.samples, minSamples)) / minSamples);
+        const float v = range > 0.0f ? std::clamp(octaves / range, 0.0f, 1.0f) : 1.0f;
+        for (int y = tile.rect.y0; y < tile.rect.y1; ++y) {
+            for (int x = tile.rect.x0; x < tile.rect.x1; ++x)
+                heatmap.at(x, y) = glm::vec3(v);
+        }
+    }
+    return heatmap;
+}
+
+double imageRmse(const Framebuffer& a, const Framebuffer& b) {
+    if (a.pixels.size() != b.pixels.size() || a.pixels.empty())
+        return 0.0;
+    double sum = 0.0;
+    for (size_t i = 0; i < a.pixels.size(); ++i) {
+        const double d = static_cast<double>(luminance(a.pixels[i]) - luminance(b.pixels[i]));
+        sum += d * d;
+    }
+    return std::sqrt(sum / static_cast<double>(a.pixels.size()));
+}
@@ -0,0 +1,73 @@
+// AdaptiveRenderer.hpp
+// ---------------------------------------------------------
+// Adaptive sampling: samples go where the image is still noisy
+// Features:
+//  - Welford mean / variance per pixel (luminance), updated one
+//    sample at a time
+//  - Per-tile error = RMS standard error of the tile's pixel means
+//  - Tiles below the threshold stop; each noisy tile asks for the
+//    samples its error says it still needs (at most doubling per round)
+//  - Work items are tile block-rows on the thread pool, so threads
+//    freed by converged tiles pick up the remaining noisy ones
+// ---------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Camera.hpp"
+#include "RayTracer.hpp"
+
+struct AdaptiveSettings {
+    float threshold = 0.005f;   // Target standard error per tile (linear luminance, 1/255 ~ 0.004)
+    int minSamples = 8;         // Per pixel before the variance estimate is trusted
+    int maxSamples = 1024;      // Per pixel cap: tiles stop here even when still noisy
+    int samplesPerRound = 4;    // Smallest increment for a tile that is still noisy (capped at minSamples)
+};
+
+struct AdaptiveStats : RenderStats {
+    int rounds = 0;
+    int tiles = 0;
+    int convergedTiles = 0;     // Reached the threshold (the rest hit maxSamples)
+    double meanSamples = 0.0;   // Per pixel, over the whole image
+    float estimatedError = 0.0f; // RMS standard error over the image
+};
+
+class AdaptiveRenderer {
+public:
+    // Renders until every tile is below adaptive.threshold or at maxSamples.
+    // settings.width / height / tileSize / seed / shadows / packets apply;
+    // samplesPerPixel and firstSample are managed here.
+    AdaptiveStats render(const RayTracer& tracer, const Camera& camera, const RenderSettings& settings,
+                         const AdaptiveSettings& adaptive);
+
+    // Per-pixel mean of the last render (linear RGB, row 0 at the top)
+    const Framebuffer& image() const { return mean; }
+
+    // Samples per pixel as a heat map: black = minSamples, white = maxSamples (log scale)
+    Framebuffer sampleHeatmap() const;
+
+private:
+    struct Tile {
+        Noise::TileRect rect;
+        int samples = 0;        // Per pixel (every pixel of a tile gets the same count)
+        float error = 0.0f;
+        bool done = false;
+    };
+
+    Framebuffer mean;
+    std::vector<float> luminanceMean;   // Welford running mean / sum of squared deviations
+    std::vector<float> luminanceM2;
+    std::vector<Tile> tiles;
+    int minSamples = 1;
+    int maxSamples = 1;
+};
+
+// Rec. 709 luminance of a linear RGB color
+inline float luminance(const glm::vec3& c) {
+    return 0.2126f * c.r + 0.7152f * c.g + 0.0722f * c.b;
+}
+
+// Root mean square luminance difference of two same-sized images
+double imageRmse(const Framebuffer& a, const Framebuffer& b);
@@ -0,0 +1,330 @@
+// Bvh.cpp
+// ---------------------------------------------------------
+// Binned SAH BVH builder (see Bvh.hpp)
+// ---------------------------------------------------------
+
+#include "Bvh.hpp"
+
+#include <chrono>
+#include <functional>
+
+#include "ThreadPool.hpp"
+
+namespace {
+
+constexpr int maxBins = 64;
+constexpr int maxBuildDepth = 64;       // SAH levels; median splits below stay within the 128-entry traversal stacks
+constexpr uint32_t parallelChunk = 1u << 16; // Primitives per task when one range is reduced in parallel
+
+struct RangeInfo {
+    Bounds bounds;          // Of the primitives
+    Bounds centroidBounds;  // Of their centroids (what the bins split)
+};
+
+struct Bin {
+    Bounds bounds;
+    uint32_t count = 0;
+};
+
+struct AxisBins {
+    Bin bins[3][maxBins];
+};
+
+struct Split {
+    int axis = -1;
+    int bin = 0;            // Primitives in bins [0, bin) go left
+    float cost = std::numeric_limits<float>::infinity();
+};
+
+class Builder {
+public:
+    Builder(const std::vector<Bounds>& bounds, std::vector<uint32_t>& indices, const BvhBuildSettings& settings)
+        : bounds(bounds), indices(indices), settings(settings),
+          bins(std::clamp(settings.bins, 2, maxBins)),
+          maxLeaf(static_cast<uint32_t>(std::max(settings.maxLeafSize, 1))),
+          parallelThreshold(static_cast<uint32_t>(std::max(settings.parallelThreshold, 2))),
+          parallel(Noise::thread_count() > 1)
+    {
+        centroids.resize(bounds.size());
+        forChunks(0, static_cast<uint32_t>(bounds.size()), [&](uint32_t b, uint32_t e) {
+            for (uint32_t i = b; i < e; ++i)
+                centroids[i] = bounds[i].center();
+        });
+    }
+
+    // Appends the subtree over indices[begin, end) to `out` in depth-first order.
+    // Node links are relative to out[0]; the caller offsets them when splicing.
+    void build(uint32_t begin, uint32_t end, int depth, std::vector<BvhNode>& out, int& maxDepth) {
+        maxDepth = std::max(maxDepth, depth);
+        const RangeInfo info = measure(begin, end);
+        const uint32_t count = end - begin;
+
+        const uint32_t nodeIndex = static_cast<uint32_t>(out.size());
+        out.push_back(BvhNode{ info.bounds.min, begin, info.bounds.max, count });
+
+        uint32_t mid = begin;
+        if (!chooseAndPartition(begin, end, depth, info, mid))
+            return; // leaf
+
+        out[nodeIndex].count = 0;
+        if (parallel && count >= parallelThreshold) {
+            // Both halves as pool tasks, then splice them in depth-first order
+            std::vector<BvhNode> halves[2];
+            int depths[2] = { depth + 1, depth + 1 };
+            Noise::ThreadPool::global().parallel_for(2, [&](size_t side) {
+                if (side == 0)
+                    build(begin, mid, depth + 1, halves[0], depths[0]);
+                else
+                    build(mid, end, depth + 1, halves[1], depths[1]);
+            });
+            maxDepth = std::max(maxDepth, std::max(depths[0], depths[1]));
+            splice(out, halves[0]);
+            out[nodeIndex].index = static_cast<uint32_t>(out.size());
+            splice(out, halves[1]);
+        }
+        else {
+            build(begin, mid, depth + 1, out, maxDepth);
+            out[nodeIndex].index = static_cast<uint32_t>(out.size());
+            build(mid, end, depth + 1, out, maxDepth);
+        }
+    }
+
+private:
+    const std::vector<Bounds>& bounds;
+    std::vector<uint32_t>& indices;
+    std::vector<glm::vec3> centroids;
+    const BvhBuildSettings& settings;
+    const int bins;
+    const uint32_t maxLeaf;
+    const uint32_t parallelThreshold;
+    const bool parallel;
+
+    // Runs fn(b, e) over [begin, end), in parallel chunks when the range is large
+    void forChunks(uint32_t begin, uint32_t end, const std::function<void(uint32_t, uint32_t)>& fn) const {
+        const uint32_t count = end - begin;
+        if (!parallel || count < 2 * parallelChunk) {
+            fn(begin, end);
+            return;
+        }
+        const size_t chunks = (count + parallelChunk - 1) / parallelChunk;
+        Noise::ThreadPool::global().parallel_for(chunks, [&](size_t c) {
+            const uint32_t b = begin + static_cast<uint32_t>(c) * parallelChunk;
+            fn(b, std::min(b + parallelChunk, end));
+        });
+    }
+
+    size_t chunkCount(uint32_t begin, uint32_t end) const {
+        const uint32_t count = end - begin;
+        return (!parallel || count < 2 * parallelChunk) ? 1 : (count + parallelChunk - 1) / parallelChunk;
+    }
+
+    RangeInfo measure(uint32_t begin, uint32_t end) const {
+        std::vector<RangeInfo> partial(chunkCount(begin, end));
+        forChunks(begin, end, [&](uint32_t b, uint32_t e) {
+            RangeInfo& info = partial[partial.size() == 1 ? 0 : (b - begin) / parallelChunk];
+            for (uint32_t i = b; i < e; ++i) {
+                const uint32_t prim = indices[i];
+                info.bounds.grow(bounds[prim]);
+                info.centroidBounds.grow(centroids[prim]);
+            }
+        });
+        RangeInfo total;
+        for (const RangeInfo& p : partial) {
+            total.bounds.grow(p.bounds);
+            total.centroidBounds.grow(p.centroidBounds);
+        }
+        return total;
+    }
+
+    int binOf(float c, float lo, float scale) const {
+        return std::min(bins - 1, static_cast<int>((c - lo) * scale));
+    }
+
+    Split findSplit(uint32_t begin, uint32_t end, const RangeInfo& info) const {
+        const glm::vec3 lo = info.centroidBounds.min;
+        const glm::vec3 extent = info.centroidBounds.max - lo;
+        glm::vec3 scale(0.0f);
+        for (int a = 0; a < 3; ++a)
+            scale[a] = extent[a] > 0.0f ? static_cast<float>(bins) / extent[a] : 0.0f;
+
+        std::vector<AxisBins> partial(chunkCount(begin, end));
+        forChunks(begin, end, [&](uint32_t b, uint32_t e) {
+            AxisBins& local = partial[partial.size() == 1 ? 0 : (b - begin) / parallelChunk];
+            for (uint32_t i = b; i < e; ++i) {
+                const uint32_t prim = indices[i];
+                const glm::vec3& c = centroids[prim];
+                for (int a = 0; a < 3; ++a) {
+                    if (scale[a] == 0.0f)
+                        continue;
+                    Bin& bin = local.bins[a][binOf(c[a], lo[a], scale[a])];
+                    bin.bounds.grow(bounds[prim]);
+                    ++bin.count;
+                }
+            }
+        });
+
+        Split best;
+        const float parentArea = info.bounds.surfaceArea();
+        const float invParentArea = parentArea > 0.0f ? 1.0f / parentArea : 0.0f;
+        for (int a = 0; a < 3; ++a) {
+            if (scale[a] == 0.0f)
+                continue;
+            Bin merged[maxBins];
+            for (const AxisBins& p : partial) {
+                for (int k = 0; k < bins; ++k) {
+                    merged[k].bounds.grow(p.bins[a][k].bounds);
+                    merged[k].count += p.bins[a][k].count;
+                }
+            }
+
+            // Sweep from the right to get the cost of every suffix, then from the left
+            float rightCost[maxBins];
+            Bounds right;
+            uint32_t rightCount = 0;
+            for (int k = bins - 1; k > 0; --k) {
+                right.grow(merged[k].bounds);
+                rightCount += merged[k].count;
+                rightCost[k] = right.surfaceArea() * static_cast<float>(rightCount);
+            }
+            Bounds left;
+            uint32_t leftCount = 0;
+            for (int k = 1; k < bins; ++k) {
+                left.grow(merged[k - 1].bounds);
+                leftCount += merged[k - 1].count;
+                if (leftCount == 0 || leftCount == end - begin)
+                    continue;
+                const float cost = settings.traversalCost
+                    + (left.surfaceArea() * static_cast<float>(leftCount) + rightCost[k]) * invParentArea;
+                if (cost < best.cost) {
+                    best.axis = a;
+                    best.bin = k;
+                    best.cost = cost;
+                }
+            }
+        }
+        return best;
+    }
+
+    // Returns false for a leaf; otherwise partitions the range and sets `mid`
+    bool chooseAndPartition(uint32_t begin, uint32_t end, int depth, const RangeInfo& info, uint32_t& mid) {
+        const uint32_t count = end - begin;
+        if (count <= 1)
+            return false;
+
+        if (depth < maxBuildDepth) {
+            const Split split = findSplit(begin, end, info);
+            const float leafCost = static_cast<float>(count);
+            if (split.axis < 0 || (count <= maxLeaf && leafCost <= split.cost)) {
+                if (count <= maxLeaf)
+                    return false;
+            }
+            else {
+                const int a = split.axis;
+                const float lo = info.centroidBounds.min[a];
+                const float scale = static_cast<float>(bins) / (info.centroidBounds.max[a] - lo);
+                auto* first = indices.data() + begin;
+                auto* middle = std::partition(first, indices.data() + end, [&](uint32_t prim) {
+                    return binOf(centroids[prim][a], lo, scale) < split.bin;
+                });
+                mid = static_cast<uint32_t>(middle - indices.data());
+                if (mid != begin && mid != end)
+                    return true;
+            }
+        }
+
+        // Coincident centroids, or too deep: split the range in half along the widest axis
+        const glm::vec3 extent = info.centroidBounds.max - info.centroidBounds.min;
+        const int a = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+        mid = begin + count / 2;
+        std::nth_element(indices.data() + begin, indices.data() + mid, indices.data() + end,
+                         [&](uint32_t l, uint32_t r) { return centroids[l][a] < centroids[r][a]; });
+        return true;
+    }
+
+    static void splice(std::vector<BvhNode>& out, const std::vector<BvhNode>& subtree) {
+        const uint32_t offset = static_cast<uint32_t>(out.size());
+        out.reserve(out.size() + subtree.size());
+        for (BvhNode node : subtree) {
+            if (!node.isLeaf())
+                node.index += offset;
+            out.push_back(node);
+        }
+    }
+};
+
+} // namespace
+
+BvhStats Bvh::build(const std::vector<Bounds>& primitiveBounds, const BvhBuildSettings& settings) {
+    const auto start = std::chrono::steady_clock::now();
+    nodes.clear();
+    primitives.resize(primitiveBounds.size());
+    for (size_t i = 0; i < primitives.size(); ++i)
+        primitives[i] = static_cast<uint32_t>(i);
+
+    BvhStats stats;
+    if (primitives.empty())
+        return stats;
+
+    nodes.reserve(2 * primitives.size() / std::max(settings.maxLeafSize, 1) + 1);
+    Builder builder(primitiveBounds, primitives, settings);
+    builder.build(0, static_cast<uint32_t>(primitives.size()), 0, nodes, stats.maxDepth);
+    nodes.shrink_to_fit();
+
+    stats.buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.nodes = nodes.size();
+    const float rootArea = Bounds{ nodes[0].boundsMin, nodes[0].boundsMax }.surfaceArea();
+    const float invRootArea = rootArea > 0.0f ? 1.0f / rootArea : 0.0f;
+    for (const BvhNode& node : nodes) {
+        const float area = Bounds{ node.boundsMin, node.boundsMax }.surfaceArea() * invRootArea;
+        if (node.isLeaf()) {
+            ++stats.leaves;
+            stats.sahCost += area * static_cast<float>(node.count);
+        }
+        else {
+            stats.sahCost += area * settings.traversalCost;
+        }
+    }
+    return stats;
+}
+
+BvhStats Bvh::build(const std::vector<AABB>& boxes, const BvhBuildSettings& settings) {
+    std::vector<Bounds> primitiveBounds(boxes.size());
+    for (size_t i = 0; i < boxes.size(); ++i)
+        primitiveBounds[i] = Bounds{ boxes[i].min, boxes[i].max };
+    return build(primitiveBounds, settings);
+}
+
+void Bvh::refit(const std::vector<Bounds>& primitiveBounds) {
+    // Depth-first order puts both children after their parent: walk backwards
+    for (size_t i = nodes.size(); i-- > 0;) {
+        BvhNode& node = nodes[i];
+        Bounds box;
+        if (node.isLeaf()) {
+            for (uint32_t k = 0; k < node.count; ++k)
+                box.grow(primitiveBounds[primitives[node.index + k]]);
+        }
+        else {
+            const BvhNode& left = nodes[i + 1];
+            const BvhNode& right = nodes[node.index];
+            box.grow(Bounds{ left.boundsMin, left.boundsMax });
+            box.grow(Bounds{ right.boundsMin, right.boundsMax });
+        }
+        node.boundsMin = box.min;
+        node.boundsMax = box.max;
+    }
+}
+
+int Bvh::intersectBoxes(const std::vector<AABB>& boxes, const glm::vec3& origin, const glm::vec3& direction,
+                        float tMax, float* hitT) const {
+    const BvhRay ray(origin, direction);
+    int hitBox = -1;
+    const float t = traverse(origin, direction, 0.0f, tMax, [&](uint32_t box, float closest) {
+        const float tBox = ray.slab(boxes[box].min, boxes[box].max, 0.0f, closest);
+        if (tBox < closest)
+            hitBox = static_cast<int>(box);
+        return tBox;
+    });
+    if (hitT != nullptr)
+        *hitT = t;
+    return hitBox;
+}
@@ -0,0 +1,243 @@
+// Bvh.hpp
+// ---------------------------------------------------------
+// Bounding volume hierarchy for ray queries
+// Features:
+//  - Binned SAH builder over any primitive with an AABB
+//    (triangle soups, CollisionManager boxes, ...)
+//  - Top levels built in parallel on RelNo_D1's thread pool
+//  - Flattened depth-first node array, 32 bytes per node:
+//    the left child is the next node, the right child is stored
+//  - Ordered traversal: near child first, far child on a small
+//    stack and skipped once a closer hit is known
+//  - Refit: moved primitives only update the node boxes, O(nodes)
+// ---------------------------------------------------------
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "Collision.hpp"
+
+// Axis-aligned box that starts empty (unlike Collision.hpp's AABB)
+struct Bounds {
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::infinity());
+    glm::vec3 max = glm::vec3(-std::numeric_limits<float>::infinity());
+
+    void grow(const glm::vec3& p) {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+
+    void grow(const Bounds& b) {
+        min = glm::min(min, b.min);
+        max = glm::max(max, b.max);
+    }
+
+    bool empty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+
+    glm::vec3 center() const { return (min + max) * 0.5f; }
+
+    float surfaceArea() const {
+        if (empty())
+            return 0.0f;
+        const glm::vec3 d = max - min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+};
+
+// 32-byte flattened node (two per cache line)
+struct alignas(32) BvhNode {
+    glm::vec3 boundsMin;
+    uint32_t index;     // Leaf: first entry in Bvh::primitives; interior: right child (left child = this + 1)
+    glm::vec3 boundsMax;
+    uint32_t count;     // Primitives in the leaf, 0 = interior node
+
+    bool isLeaf() const { return count > 0; }
+};
+static_assert(sizeof(BvhNode) == 32, "BvhNode must stay 32 bytes");
+
+struct BvhBuildSettings {
+    int bins = 16;              // SAH candidate planes per axis
+    int maxLeafSize = 4;        // Leaves never hold more than this
+    float traversalCost = 1.0f; // SAH cost of visiting a node, relative to one primitive test
+    int parallelThreshold = 8192; // Subtrees at least this big are built as separate pool tasks
+};
+
+struct BvhStats {
+    double buildSeconds = 0.0;
+    size_t nodes = 0;
+    size_t leaves = 0;
+    int maxDepth = 0;
+    float sahCost = 0.0f;       // Expected cost of a random ray, in primitive tests
+};
+
+// Precomputed per-ray data for the slab tests
+struct BvhRay {
+    glm::vec3 origin;
+    glm::vec3 invDirection;
+
+    BvhRay() = default;
+    BvhRay(const glm::vec3& origin, const glm::vec3& direction)
+        : origin(origin), invDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z) {}
+
+    // Entry distance into [boxMin, boxMax] within [tMin, tMax], or +inf on a miss
+    float slab(const glm::vec3& boxMin, const glm::vec3& boxMax, float tMin, float tMax) const {
+        const glm::vec3 t0 = (boxMin - origin) * invDirection;
+        const glm::vec3 t1 = (boxMax - origin) * invDirection;
+        const glm::vec3 tSmall = glm::min(t0, t1);
+        const glm::vec3 tLarge = glm::max(t0, t1);
+        const float tEnter = std::max(std::max(tSmall.x, tSmall.y), std::max(tSmall.z, tMin));
+        const float tExit = std::min(std::min(tLarge.x, tLarge.y), std::min(tLarge.z, tMax));
+        return tEnter <= tExit ? tEnter : std::numeric_limits<float>::infinity();
+    }
+};
+
+class Bvh {
+public:
+    std::vector<BvhNode> nodes;         // nodes[0] is the root (empty if there are no primitives)
+    std::vector<uint32_t> primitives;   // Leaf ranges index into this; values are the caller's primitive ids
+
+    // Builds over one AABB per primitive
+    BvhStats build(const std::vector<Bounds>& primitiveBounds, const BvhBuildSettings& settings = {});
+
+    // CollisionManager-style boxes (e.g. collisionMgr.boxes)
+    BvhStats build(const std::vector<AABB>& boxes, const BvhBuildSettings& settings = {});
+
+    // Recomputes every node box bottom-up from new primitive boxes (same ids
+    // as the last build). Keeps the tree shape, so quality drops if
+    // primitives travel far; rebuild then.
+    void refit(const std::vector<Bounds>& primitiveBounds);
+
+    bool empty() const { return nodes.empty(); }
+
+    // Closest-hit traversal. `intersect(primitiveId, tMax)` returns the hit
+    // distance (or +inf) and is only asked for hits closer than tMax.
+    template<typename IntersectFn>
+    float traverse(const glm::vec3& origin, const glm::vec3& direction, float tMin, float tMax, IntersectFn&& intersect) const {
+        if (nodes.empty())
+            return std::numeric_limits<float>::infinity();
+
+        const BvhRay ray(origin, direction);
+        float closest = tMax;
+        bool found = false;
+
+        struct Entry { uint32_t node; float tEnter; };
+        Entry stack[128];
+        int stackSize = 0;
+
+        uint32_t current = 0;
+        if (ray.slab(nodes[0].boundsMin, nodes[0].boundsMax, tMin, closest) == std::numeric_limits<float>::infinity())
+            return std::numeric_limits<float>::infinity();
+
+        for (;;) {
+            const BvhNode& node = nodes[current];
+            if (node.isLeaf()) {
+                for (uint32_t i = 0; i < node.count; ++i) {
+                    const float t = intersect(primitives[node.index + i], closest);
+                    if (t >= tMin && t < closest) {
+                        closest = t;
+                        found = true;
+                    }
+                }
+            }
+            else {
+                uint32_t nearChild = current + 1;
+                uint32_t farChild = node.index;
+                float tNear = ray.slab(nodes[nearChild].boundsMin, nodes[nearChild].boundsMax, tMin, closest);
+                float tFar = ray.slab(nodes[farChild].boundsMin, nodes[farChild].boundsMax, tMin, closest);
+                if (tFar < tNear) {
+                    std::swap(nearChild, farChild);
+                    std::swap(tNear, tFar);
+                }
+                if (tNear != std::numeric_limits<float>::infinity()) {
+                    if (tFar != std::numeric_limits<float>::infinity())
+                        stack[stackSize++] = { farChild, tFar };
+                    current = nearChild;
+                    continue;
+                }
+            }
+
+            // Pop the next subtree that can still hold a closer hit
+            for (;;) {
+                if (stackSize == 0)
+                    return found ? closest : std::numeric_limits<float>::infinity();
+                const Entry entry = stack[--stackSize];
+                if (entry.tEnter < closest) {
+                    current = entry.node;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Any-hit traversal: stops at the first primitive for which `hit(primitiveId)` is true
+    template<typename HitFn>
+    bool traverseAny(const glm::vec3& origin, const glm::vec3& direction, float tMin, float tMax, HitFn&& hit) const {
+        if (nodes.empty())
+            return false;
+
+        const BvhRay ray(origin, direction);
+        uint32_t stack[128];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+
+        while (stackSize > 0) {
+            const uint32_t index = stack[--stackSize];
+            const BvhNode& node = nodes[index];
+            if (ray.slab(node.boundsMin, node.boundsMax, tMin, tMax) == std::numeric_limits<float>::infinity())
+                continue;
+            if (node.isLeaf()) {
+                for (uint32_t i = 0; i < node.count; ++i) {
+                    if (hit(primitives[node.index + i]))
+                        return true;
+                }
+            }
+            else {
+                stack[stackSize++] = node.index;
+                stack[stackSize++] = index + 1;
+            }
+        }
+        return false;
+    }
+
+    // Calls fn(primitiveId) for every primitive whose leaf box overlaps `box`
+    template<typename Fn>
+    void queryOverlap(const Bounds& box, Fn&& fn) const {
+        if (nodes.empty())
+            return;
+        uint32_t stack[128];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0) {
+            const uint32_t index = stack[--stackSize];
+            const BvhNode& node = nodes[index];
+            if (glm::any(glm::lessThan(node.boundsMax, box.min)) || glm::any(glm::greaterThan(node.boundsMin, box.max)))
+                continue;
+            if (node.isLeaf()) {
+                for (uint32_t i = 0; i < node.count; ++i)
+                    fn(primitives[node.index + i]);
+            }
+            else {
+                stack[stackSize++] = node.index;
+                stack[stackSize++] = index + 1;
+            }
+        }
+    }
+
+    // Nearest box hit along a ray, for CollisionManager-style boxes (-1 if none)
+    int intersectBoxes(const std::vector<AABB>& boxes, const glm::vec3& origin, const glm::vec3& direction,
+                       float tMax = std::numeric_limits<float>::infinity(), float* hitT = nullptr) const;
+};
+
+// Bounds of one triangle
+inline Bounds triangleBounds(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    Bounds box;
+    box.grow(a);
+    box.grow(b);
+    box.grow(c);
+    return box;
+}
@@ -6,6 +6,7 @@
 //  - Mouse look (when right button held)
 //  - Q/E for vertical movement
 //  - Shift for speed boost
+//  - viewVersion counts view changes (progressive ray tracing restarts on it)
 // ---------------------------------------------------------
 
 #pragma once
@@ -39,6 +40,9 @@ public:
     float lastX;
     float lastY;
 
+    // Bumped by every input call that actually moves, turns or zooms the view
+    unsigned int viewVersion;
+
     // Constructor with vectors
     Camera(
         glm::vec3 position = glm::vec3(0.0f, 0.0f, 3.0f),
@@ -53,7 +57,8 @@ public:
         collisionRadius(0.1f),
         firstMouse(true),
         lastX(400.0f),
-        lastY(300.0f)
+        lastY(300.0f),
+        viewVersion(0)
     {
         this->position = position;
         this->worldUp = up;
@@ -107,11 +112,14 @@ public:
             newPosition -= worldUp * velocity;
 
         // Apply collision detection if manager is provided
+        const glm::vec3 oldPosition = position;
         if (collisionMgr != nullptr) {
             position = collisionMgr->resolveCollision(position, newPosition, collisionRadius);
         } else {
             position = newPosition;
         }
+        if (position != oldPosition)
+            ++viewVersion;
     }
 
     // Process mouse movement
@@ -134,6 +142,9 @@ public:
         lastX = xpos;
         lastY = ypos;
 
+        if (xoffset == 0.0f && yoffset == 0.0f)
+            return;
+
         xoffset *= mouseSensitivity;
         yoffset *= mouseSensitivity;
 
@@ -147,15 +158,19 @@ public:
             pitch = -89.0f;
 
         updateCameraVectors();
+        ++viewVersion;
     }
 
     // Process mouse scroll (zoom)
     void processMouseScroll(float yoffset) {
+        const float oldZoom = zoom;
         zoom -= yoffset;
         if (zoom < 1.0f)
             zoom = 1.0f;
         if (zoom > 45.0f)
             zoom = 45.0f;
+        if (zoom != oldZoom)
+            ++viewVersion;
     }
 
 private:
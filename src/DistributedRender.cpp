@@ -0,0 +1,980 @@
+// DistributedRender.cpp
+// ---------------------------------------------------------
+// Socket protocol, coordinator and worker (see DistributedRender.hpp)
+//
+// Every message is a 16-byte header { magic, type, payload size }
+// followed by the payload:
+//   Hello       worker -> coordinator   threads, pid
+//   Scene       coordinator -> worker   serializeScene() bytes
+//   Frame       coordinator -> worker   frame id, CameraPose, RenderSettings
+//   Tile        coordinator -> worker   frame id, tile index, rect
+//   TileResult  worker -> coordinator   frame id, tile index, rect, rays,
+//                                       seconds, RGB floats of the rect
+//   Shutdown    coordinator -> worker   (empty)
+// ---------------------------------------------------------
+
+#include "DistributedRender.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <thread>
+#include <type_traits>
+
+#include "ThreadPool.hpp"
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// -----------------------------
+// Byte buffers
+// -----------------------------
+class ByteWriter {
+public:
+    explicit ByteWriter(std::vector<uint8_t>& out) : out(out) {}
+
+    template<typename T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    template<typename T>
+    void putArray(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        put(static_cast<uint64_t>(values.size()));
+        const auto* bytes = reinterpret_cast<const uint8_t*>(values.data());
+        out.insert(out.end(), bytes, bytes + values.size() * sizeof(T));
+    }
+
+private:
+    std::vector<uint8_t>& out;
+};
+
+class ByteReader {
+public:
+    ByteReader(const uint8_t* data, size_t size) : cursor(data), end(data + size) {}
+
+    template<typename T>
+    bool get(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (static_cast<size_t>(end - cursor) < sizeof(T))
+            return false;
+        std::memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return true;
+    }
+
+    template<typename T>
+    bool getArray(std::vector<T>& values) {
+        uint64_t count = 0;
+        if (!get(count) || count > static_cast<uint64_t>(end - cursor) / sizeof(T))
+            return false;
+        values.resize(static_cast<size_t>(count));
+        std::memcpy(values.data(), cursor, values.size() * sizeof(T));
+        cursor += values.size() * sizeof(T);
+        return true;
+    }
+
+    size_t remaining() const { return static_cast<size_t>(end - cursor); }
+    const uint8_t* position() const { return cursor; }
+
+private:
+    const uint8_t* cursor;
+    const uint8_t* end;
+};
+
+constexpr uint32_t sceneFormatVersion = 3;   // 2: noise patterns, 3: fog volumes
+
+// A worker bakes every pattern and fog grid before it renders; scenes asking
+// for more than this are rejected instead of allocating gigabytes
+constexpr int maxOctaves = 32;
+constexpr uint64_t maxPatternTexels = uint64_t(8192) * 8192;   // All patterns together (one 8192^2 texture)
+constexpr double maxFogCells = 1 << 20;                         // All fog grids together (~256 MB of lattice)
+
+bool finite(const glm::vec3& v) {
+    return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z);
+}
+
+bool validMaterial(const Triangle& triangle, const Scene& scene) {
+    // A scene without materials gets one default material
+    return triangle.material >= 0 && triangle.material < std::max(static_cast<int>(scene.materials.size()), 1);
+}
+
+} // namespace
+
+// -----------------------------
+// Scene serialization
+// -----------------------------
+void serializeScene(const Scene& scene, std::vector<uint8_t>& out) {
+    ByteWriter w(out);
+    w.put(sceneFormatVersion);
+    w.putArray(scene.triangles);
+    w.put(static_cast<uint64_t>(scene.meshes.size()));
+    for (const Mesh& mesh : scene.meshes)
+        w.putArray(mesh.triangles);
+    w.putArray(scene.instances);
+    w.putArray(scene.materials);
+    w.putArray(scene.patterns);
+    w.putArray(scene.fogVolumes);
+    w.put(scene.light);
+    w.put(scene.background);
+}
+
+bool deserializeScene(const std::vector<uint8_t>& data, Scene& scene) {
+    ByteReader r(data.data(), data.size());
+    uint32_t version = 0;
+    uint64_t meshCount = 0;
+    if (!r.get(version) || version != sceneFormatVersion)
+        return false;
+    if (!r.getArray(scene.triangles) || !r.get(meshCount) || meshCount > r.remaining())
+        return false;
+    scene.meshes.resize(static_cast<size_t>(meshCount));
+    for (Mesh& mesh : scene.meshes) {
+        if (!r.getArray(mesh.triangles))
+            return false;
+    }
+    if (!r.getArray(scene.instances) || !r.getArray(scene.materials) || !r.getArray(scene.patterns) ||
+        !r.getArray(scene.fogVolumes) || !r.get(scene.light) || !r.get(scene.background))
+        return false;
+    for (const Instance& instance : scene.instances) {
+        if (instance.mesh < 0 || instance.mesh >= static_cast<int>(scene.meshes.size()))
+            return false;
+    }
+    for (const Material& material : scene.materials) {
+        if (material.pattern >= static_cast<int>(scene.patterns.size()))
+            return false;
+    }
+    for (const Triangle& triangle : scene.triangles) {
+        if (!validMaterial(triangle, scene))
+            return false;
+    }
+    for (const Mesh& mesh : scene.meshes) {
+        for (const Triangle& triangle : mesh.triangles) {
+            if (!validMaterial(triangle, scene))
+                return false;
+        }
+    }
+    uint64_t patternTexels = 0;
+    for (const NoisePattern& pattern : scene.patterns) {
+        if (pattern.octaves > maxOctaves)
+            return false;
+        const uint64_t size = static_cast<uint64_t>(NoiseTexture::sizeFor(pattern.resolution));
+        patternTexels += size * size;
+    }
+    double fogCells = 0.0;
+    for (const NoiseFog& fog : scene.fogVolumes) {
+        if (fog.octaves > maxOctaves || !finite(fog.boundsMin) || !finite(fog.boundsMax))
+            return false;
+        fogCells += FogVolume::cellCountFor(fog);
+    }
+    if (patternTexels > maxPatternTexels || !(fogCells <= maxFogCells))
+        return false;
+    return r.remaining() == 0;
+}
+
+#ifndef _WIN32
+
+namespace {
+
+// -----------------------------
+// Messages
+// -----------------------------
+constexpr uint32_t protocolMagic = 0x31575452u;    // "RTW1"
+constexpr uint64_t maxPayload = uint64_t(1) << 32;
+
+enum class MessageType : uint32_t {
+    Hello = 1,
+    SceneData,
+    Frame,
+    Tile,
+    TileResult,
+    Shutdown,
+};
+
+struct MessageHeader {
+    uint32_t magic = protocolMagic;
+    uint32_t type = 0;
+    uint64_t size = 0;
+};
+
+struct FrameMessage {
+    uint32_t frame = 0;
+    CameraPose pose;
+    int32_t width = 0, height = 0, tileSize = 0, samplesPerPixel = 0, firstSample = 0;
+    uint8_t shadows = 1, packets = 1;
+    uint32_t seed = 0;
+};
+
+struct TileMessage {
+    uint32_t frame = 0;
+    uint32_t tile = 0;
+    int32_t x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+};
+
+struct TileResultHeader {
+    TileMessage tile;
+    uint64_t primaryRays = 0;
+    uint64_t shadowRays = 0;
+    double seconds = 0.0;
+};
+
+template<typename T>
+std::vector<uint8_t> payloadOf(const T& value) {
+    std::vector<uint8_t> payload;
+    ByteWriter(payload).put(value);
+    return payload;
+}
+
+#ifdef MSG_NOSIGNAL
+constexpr int sendFlags = MSG_NOSIGNAL;
+#else
+constexpr int sendFlags = 0;
+#endif
+
+bool sendAll(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        const ssize_t n = ::send(fd, data, size, sendFlags);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            pollfd p{ fd, POLLOUT, 0 };
+            ::poll(&p, 1, 1000);
+            continue;
+        }
+        if (n <= 0)
+            return false;
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool recvAll(int fd, uint8_t* data, size_t size) {
+    while (size > 0) {
+        const ssize_t n = ::recv(fd, data, size, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool sendMessage(int fd, MessageType type, const std::vector<uint8_t>& payload = {}) {
+    MessageHeader header;
+    header.type = static_cast<uint32_t>(type);
+    header.size = payload.size();
+    return sendAll(fd, reinterpret_cast<const uint8_t*>(&header), sizeof(header))
+        && sendAll(fd, payload.data(), payload.size());
+}
+
+// Blocking receive (worker side)
+bool recvMessage(int fd, MessageType& type, std::vector<uint8_t>& payload) {
+    MessageHeader header;
+    if (!recvAll(fd, reinterpret_cast<uint8_t*>(&header), sizeof(header)) || header.magic != protocolMagic
+        || header.size > maxPayload)
+        return false;
+    type = static_cast<MessageType>(header.type);
+    payload.resize(static_cast<size_t>(header.size));
+    return recvAll(fd, payload.data(), payload.size());
+}
+
+// -----------------------------
+// Addresses
+// -----------------------------
+struct SocketAddress {
+    bool unixSocket = false;
+    std::string path;               // Unix socket
+    std::string host = "127.0.0.1"; // TCP
+    int port = 0;
+};
+
+bool parseAddress(const std::string& text, SocketAddress& address, std::string& error) {
+    if (text.rfind("unix:", 0) == 0) {
+        address.unixSocket = true;
+        address.path = text.substr(5);
+        if (address.path.empty() || address.path.size() >= sizeof(sockaddr_un::sun_path)) {
+            error = "bad unix socket path: " + text;
+            return false;
+        }
+        return true;
+    }
+    if (text.rfind("tcp:", 0) == 0) {
+        const std::string rest = text.substr(4);
+        const size_t colon = rest.rfind(':');
+        const std::string port = colon == std::string::npos ? rest : rest.substr(colon + 1);
+        if (colon != std::string::npos)
+            address.host = rest.substr(0, colon);
+        try {
+            address.port = std::stoi(port);
+        }
+        catch (const std::exception&) {
+            address.port = -1;
+        }
+        if (address.port < 0 || address.port > 65535 || address.host.empty()) {
+            error = "bad tcp address: " + text;
+            return false;
+        }
+        return true;
+    }
+    error = "address must start with tcp: or unix: (" + text + ")";
+    return false;
+}
+
+bool resolveTcp(const SocketAddress& address, sockaddr_in& out, std::string& error) {
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    if (::getaddrinfo(address.host.c_str(), nullptr, &hints, &result) != 0 || !result) {
+        error = "cannot resolve host " + address.host;
+        return false;
+    }
+    out = *reinterpret_cast<const sockaddr_in*>(result->ai_addr);
+    out.sin_port = htons(static_cast<uint16_t>(address.port));
+    ::freeaddrinfo(result);
+    return true;
+}
+
+int connectTo(const SocketAddress& address, std::string& error) {
+    if (address.unixSocket) {
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, address.path.c_str(), sizeof(addr.sun_path) - 1);
+        if (fd >= 0 && ::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0)
+            return fd;
+        if (fd >= 0)
+            ::close(fd);
+        error = "cannot connect to unix:" + address.path;
+        return -1;
+    }
+    sockaddr_in addr{};
+    if (!resolveTcp(address, addr, error))
+        return -1;
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0) {
+        const int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        return fd;
+    }
+    if (fd >= 0)
+        ::close(fd);
+    error = "cannot connect to tcp:" + address.host + ":" + std::to_string(address.port);
+    return -1;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Tile grid of an image, row by row (same order as parallel_for_tiles)
+std::vector<Noise::TileRect> imageTiles(int width, int height, int tileSize) {
+    std::vector<Noise::TileRect> tiles;
+    for (int y = 0; y < height; y += tileSize) {
+        for (int x = 0; x < width; x += tileSize)
+            tiles.push_back({ x, y, std::min(x + tileSize, width), std::min(y + tileSize, height) });
+    }
+    return tiles;
+}
+
+} // namespace
+
+// -----------------------------
+// Coordinator
+// -----------------------------
+struct RenderCoordinator::State {
+    struct InFlight {
+        uint32_t frame;     // Units of an earlier frame still occupy the worker until they return
+        uint32_t tile;
+        std::chrono::steady_clock::time_point sent;
+    };
+
+    struct Worker {
+        int fd = -1;
+        int id = 0;
+        unsigned threads = 1;
+        bool sceneSent = false;
+        uint32_t frameSent = 0;
+        std::vector<uint8_t> inbox;     // Bytes received, not yet a whole message
+        std::vector<InFlight> inFlight;
+    };
+
+    int listenFd = -1;
+    std::string unixPath;               // Removed again on shutdown
+    std::vector<Worker> workers;
+    int nextWorkerId = 0;
+    std::vector<uint8_t> scenePayload;
+    uint32_t frame = 0;
+    std::vector<uint8_t> framePayload;
+
+    void closeWorker(Worker& worker) {
+        if (worker.fd >= 0)
+            ::close(worker.fd);
+        worker.fd = -1;
+    }
+
+    // Brings a worker up to date: scene first, then the current frame
+    bool prepare(Worker& worker) {
+        if (!worker.sceneSent && !scenePayload.empty()) {
+            if (!sendMessage(worker.fd, MessageType::SceneData, scenePayload))
+                return false;
+            worker.sceneSent = true;
+        }
+        if (frame != 0 && worker.frameSent != frame) {
+            if (!sendMessage(worker.fd, MessageType::Frame, framePayload))
+                return false;
+            worker.frameSent = frame;
+        }
+        return true;
+    }
+
+    void acceptPending() {
+        for (;;) {
+            const int fd = ::accept(listenFd, nullptr, nullptr);
+            if (fd < 0)
+                return;
+            ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+            if (unixPath.empty()) {
+                const int one = 1;
+                ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            }
+            Worker worker;
+            worker.fd = fd;
+            worker.id = nextWorkerId++;
+            if (prepare(worker))
+                workers.push_back(std::move(worker));
+            else
+                ::close(fd);
+        }
+    }
+
+    // Reads what is available; false once the connection is gone
+    bool receive(Worker& worker) {
+        uint8_t buffer[64 * 1024];
+        for (;;) {
+            const ssize_t n = ::recv(worker.fd, buffer, sizeof(buffer), 0);
+            if (n > 0) {
+                worker.inbox.insert(worker.inbox.end(), buffer, buffer + n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR)
+                continue;
+            return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+    }
+
+    // Pops one whole message from the inbox
+    static bool nextMessage(Worker& worker, MessageType& type, std::vector<uint8_t>& payload, bool& corrupt) {
+        MessageHeader header;
+        if (worker.inbox.size() < sizeof(header))
+            return false;
+        std::memcpy(&header, worker.inbox.data(), sizeof(header));
+        if (header.magic != protocolMagic || header.size > maxPayload) {
+            corrupt = true;
+            return false;
+        }
+        if (worker.inbox.size() < sizeof(header) + header.size)
+            return false;
+        type = static_cast<MessageType>(header.type);
+        payload.assign(worker.inbox.begin() + sizeof(header), worker.inbox.begin() + sizeof(header) + header.size);
+        worker.inbox.erase(worker.inbox.begin(), worker.inbox.begin() + sizeof(header) + header.size);
+        return true;
+    }
+};
+
+RenderCoordinator::RenderCoordinator(const CoordinatorSettings& settings)
+    : coordinator(settings), state(std::make_unique<State>()) {
+    std::signal(SIGPIPE, SIG_IGN);     // A dead worker shows up as a failed send instead
+}
+
+RenderCoordinator::~RenderCoordinator() {
+    for (State::Worker& worker : state->workers) {
+        sendMessage(worker.fd, MessageType::Shutdown);
+        state->closeWorker(worker);
+    }
+    if (state->listenFd >= 0)
+        ::close(state->listenFd);
+    if (!state->unixPath.empty())
+        ::unlink(state->unixPath.c_str());
+}
+
+bool RenderCoordinator::listen(const std::string& address) {
+    SocketAddress parsed;
+    if (!parseAddress(address, parsed, lastError))
+        return false;
+
+    int fd = -1;
+    if (parsed.unixSocket) {
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, parsed.path.c_str(), sizeof(addr.sun_path) - 1);
+        ::unlink(parsed.path.c_str());
+        if (fd < 0 || ::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            lastError = "cannot bind unix:" + parsed.path;
+            if (fd >= 0)
+                ::close(fd);
+            return false;
+        }
+        state->unixPath = parsed.path;
+        boundAddress = address;
+    }
+    else {
+        sockaddr_in addr{};
+        if (!resolveTcp(parsed, addr, lastError))
+            return false;
+        fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        const int one = 1;
+        if (fd >= 0)
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (fd < 0 || ::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            lastError = "cannot bind " + address;
+            if (fd >= 0)
+                ::close(fd);
+            return false;
+        }
+        socklen_t length = sizeof(addr);
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &length);
+        boundAddress = "tcp:" + parsed.host + ":" + std::to_string(ntohs(addr.sin_port));
+    }
+    if (::listen(fd, 64) != 0) {
+        lastError = "cannot listen on " + address;
+        ::close(fd);
+        return false;
+    }
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    state->listenFd = fd;
+    return true;
+}
+
+int RenderCoordinator::workerCount() const {
+    return static_cast<int>(state->workers.size());
+}
+
+int RenderCoordinator::acceptWorkers(int count, double timeoutSeconds) {
+    const auto start = std::chrono::steady_clock::now();
+    while (state->listenFd >= 0 && workerCount() < count && secondsSince(start) < timeoutSeconds) {
+        pollfd p{ state->listenFd, POLLIN, 0 };
+        ::poll(&p, 1, 50);
+        state->acceptPending();
+    }
+    return workerCount();
+}
+
+void RenderCoordinator::setScene(const Scene& scene) {
+    state->scenePayload.clear();
+    serializeScene(scene, state->scenePayload);
+    for (State::Worker& worker : state->workers)
+        worker.sceneSent = false;
+    for (State::Worker& worker : state->workers) {
+        if (!state->prepare(worker))
+            state->closeWorker(worker);
+    }
+    std::erase_if(state->workers, [](const State::Worker& w) { return w.fd < 0; });
+}
+
+DistributedStats RenderCoordinator::render(const Camera& camera, const RenderSettings& settings, Framebuffer& target) {
+    using Clock = std::chrono::steady_clock;
+    State& s = *state;
+    DistributedStats stats;
+    const auto start = Clock::now();
+
+    const int width = std::max(settings.width, 1);
+    const int height = std::max(settings.height, 1);
+    if (target.width != width || target.height != height)
+        target.resize(width, height);
+    const std::vector<Noise::TileRect> tiles = imageTiles(width, height, std::max(settings.tileSize, 1));
+    stats.tiles = static_cast<int>(tiles.size());
+
+    // -----------------------------
+    // Announce the frame
+    // -----------------------------
+    FrameMessage frame;
+    frame.frame = ++s.frame;
+    frame.pose = CameraPose(camera);
+    frame.width = width;
+    frame.height = height;
+    frame.tileSize = std::max(settings.tileSize, 1);
+    frame.samplesPerPixel = settings.samplesPerPixel;
+    frame.firstSample = settings.firstSample;
+    frame.shadows = settings.shadows ? 1 : 0;
+    frame.packets = settings.packets ? 1 : 0;
+    frame.seed = settings.seed;
+    s.framePayload = payloadOf(frame);
+
+    std::deque<uint32_t> pending;
+    for (uint32_t t = 0; t < tiles.size(); ++t)
+        pending.push_back(t);
+    std::vector<uint8_t> done(tiles.size(), 0);
+    std::vector<uint8_t> reissued(tiles.size(), 0);
+    std::vector<double> tileSeconds;    // Send-to-result time of finished tiles
+    std::vector<int> tilesByWorker(static_cast<size_t>(s.nextWorkerId), 0);
+    std::vector<uint8_t> tookPart(static_cast<size_t>(s.nextWorkerId), 0);
+    size_t doneCount = 0;
+    auto lastWorkerSeen = Clock::now();
+
+    auto dropWorker = [&](State::Worker& worker) {
+        for (const State::InFlight& unit : worker.inFlight) {
+            if (unit.frame == s.frame && !done[unit.tile]) {
+                pending.push_front(unit.tile);
+                ++stats.requeued;
+            }
+        }
+        worker.inFlight.clear();
+        s.closeWorker(worker);
+    };
+    auto sendTile = [&](State::Worker& worker, uint32_t tile) {
+        TileMessage message;
+        message.frame = s.frame;
+        message.tile = tile;
+        message.x0 = tiles[tile].x0;
+        message.y0 = tiles[tile].y0;
+        message.x1 = tiles[tile].x1;
+        message.y1 = tiles[tile].y1;
+        worker.inFlight.push_back({ s.frame, tile, Clock::now() });
+        if (!s.prepare(worker) || !sendMessage(worker.fd, MessageType::Tile, payloadOf(message)))
+            dropWorker(worker);
+    };
+    auto handle = [&](State::Worker& worker, MessageType type, const std::vector<uint8_t>& payload) {
+        if (type == MessageType::Hello) {
+            ByteReader r(payload.data(), payload.size());
+            uint32_t threads = 1;
+            r.get(threads);
+            worker.threads = std::max(threads, 1u);
+            return true;
+        }
+        if (type != MessageType::TileResult)
+            return false;
+
+        ByteReader r(payload.data(), payload.size());
+        TileResultHeader result;
+        if (!r.get(result))
+            return false;
+        const uint32_t t = result.tile.tile;
+        const auto unit = std::find_if(worker.inFlight.begin(), worker.inFlight.end(), [&](const State::InFlight& u) {
+            return u.frame == result.tile.frame && u.tile == t;
+        });
+        if (result.tile.frame != s.frame) {
+            if (unit != worker.inFlight.end())
+                worker.inFlight.erase(unit);
+            return true;    // Late answer to an earlier frame
+        }
+        if (t >= tiles.size())
+            return false;
+        const Noise::TileRect& rect = tiles[t];
+        const size_t pixels = static_cast<size_t>(rect.x1 - rect.x0) * static_cast<size_t>(rect.y1 - rect.y0);
+        if (r.remaining() != pixels * sizeof(glm::vec3))
+            return false;
+
+        if (unit != worker.inFlight.end()) {
+            tileSeconds.push_back(std::chrono::duration<double>(Clock::now() - unit->sent).count());
+            worker.inFlight.erase(unit);
+        }
+        if (done[t]) {
+            ++stats.duplicates;
+            return true;
+        }
+
+        // Copy the rows of the tile into place
+        const uint8_t* src = r.position();
+        const size_t rowBytes = static_cast<size_t>(rect.x1 - rect.x0) * sizeof(glm::vec3);
+        for (int y = rect.y0; y < rect.y1; ++y, src += rowBytes)
+            std::memcpy(&target.at(rect.x0, y), src, rowBytes);
+        done[t] = 1;
+        ++doneCount;
+        stats.primaryRays += result.primaryRays;
+        stats.shadowRays += result.shadowRays;
+        if (static_cast<size_t>(worker.id) >= tilesByWorker.size()) {
+            tilesByWorker.resize(static_cast<size_t>(worker.id) + 1, 0);
+            tookPart.resize(static_cast<size_t>(worker.id) + 1, 0);
+        }
+        ++tilesByWorker[worker.id];
+        tookPart[worker.id] = 1;
+        return true;
+    };
+
+    for (State::Worker& worker : s.workers) {
+        if (!s.prepare(worker))
+            s.closeWorker(worker);
+    }
+
+    std::vector<pollfd> fds;
+    std::vector<uint8_t> payload;
+    while (doneCount < tiles.size()) {
+        std::erase_if(s.workers, [](const State::Worker& w) { return w.fd < 0; });
+
+        // -----------------------------
+        // Hand out tiles: keep every worker a few tiles ahead
+        // -----------------------------
+        for (State::Worker& worker : s.workers) {
+            while (worker.fd >= 0 && static_cast<int>(worker.inFlight.size()) < std::max(coordinator.tilesInFlight, 1)
+                   && !pending.empty()) {
+                const uint32_t t = pending.front();
+                pending.pop_front();
+                if (!done[t])
+                    sendTile(worker, t);
+            }
+        }
+
+        // -----------------------------
+        // Nothing left to hand out: back up tiles that take far too long
+        // on a worker with spare capacity
+        // -----------------------------
+        if (pending.empty() && !tileSeconds.empty()) {
+            std::vector<double> sorted = tileSeconds;
+            std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+            const double limit = std::max(coordinator.minSlowSeconds, coordinator.slowFactor * sorted[sorted.size() / 2]);
+            const auto now = Clock::now();
+            for (State::Worker& slow : s.workers) {
+                for (const State::InFlight& unit : slow.inFlight) {
+                    if (unit.frame != s.frame || done[unit.tile] || reissued[unit.tile]
+                        || std::chrono::duration<double>(now - unit.sent).count() < limit)
+                        continue;
+                    for (State::Worker& spare : s.workers) {
+                        if (&spare == &slow || spare.fd < 0 || !spare.inFlight.empty())
+                            continue;
+                        reissued[unit.tile] = 1;
+                        ++stats.reissued;
+                        sendTile(spare, unit.tile);
+                        break;
+                    }
+                }
+            }
+        }
+
+        // -----------------------------
+        // Wait for results (and new workers)
+        // -----------------------------
+        fds.clear();
+        fds.push_back({ s.listenFd, POLLIN, 0 });
+        for (const State::Worker& worker : s.workers)
+            fds.push_back({ worker.fd, POLLIN, 0 });
+        ::poll(fds.data(), fds.size(), 20);
+
+        if (fds[0].revents & POLLIN)
+            s.acceptPending();
+
+        for (size_t i = 1; i < fds.size() && i - 1 < s.workers.size(); ++i) {
+            State::Worker& worker = s.workers[i - 1];
+            if (worker.fd < 0 || !(fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+            const bool open = s.receive(worker);
+            bool corrupt = false;
+            MessageType type;
+            while (State::nextMessage(worker, type, payload, corrupt)) {
+                if (!handle(worker, type, payload)) {
+                    corrupt = true;
+                    break;
+                }
+            }
+            if (!open || corrupt)
+                dropWorker(worker);
+        }
+
+        if (std::any_of(s.workers.begin(), s.workers.end(), [](const State::Worker& w) { return w.fd >= 0; }))
+            lastWorkerSeen = Clock::now();
+        else if (secondsSince(lastWorkerSeen) > coordinator.workerTimeoutSeconds) {
+            lastError = "no workers left to render the frame";
+            break;
+        }
+    }
+    std::erase_if(s.workers, [](const State::Worker& w) { return w.fd < 0; });
+
+    stats.seconds = secondsSince(start);
+    stats.complete = doneCount == tiles.size();
+    stats.tilesPerWorker = tilesByWorker;
+    stats.workers = static_cast<int>(std::count(tookPart.begin(), tookPart.end(), uint8_t(1)));
+    stats.threads = 0;
+    for (const State::Worker& worker : s.workers)
+        stats.threads += worker.threads;
+    stats.threads = std::max(stats.threads, 1u);
+    return stats;
+}
+
+// -----------------------------
+// Worker
+// -----------------------------
+int runRenderWorker(const std::string& address, const WorkerSettings& settings) {
+    std::signal(SIGPIPE, SIG_IGN);
+    SocketAddress parsed;
+    std::string error;
+    if (!parseAddress(address, parsed, error)) {
+        std::fprintf(stderr, "worker: %s\n", error.c_str());
+        return 2;
+    }
+
+    // The coordinator may still be starting up
+    int fd = -1;
+    const auto start = std::chrono::steady_clock::now();
+    while ((fd = connectTo(parsed, error)) < 0 && secondsSince(start) < 10.0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    if (fd < 0) {
+        std::fprintf(stderr, "worker: %s\n", error.c_str());
+        return 1;
+    }
+
+    std::vector<uint8_t> hello;
+    ByteWriter(hello).put(static_cast<uint32_t>(Noise::thread_count()));
+    ByteWriter(hello).put(static_cast<int32_t>(::getpid()));
+    if (!sendMessage(fd, MessageType::Hello, hello)) {
+        ::close(fd);
+        return 1;
+    }
+
+    std::unique_ptr<RayTracer> tracer;
+    FrameMessage frame;
+    RenderSettings renderSettings;
+    Framebuffer image;
+    int tilesDone = 0;
+    MessageType type;
+    std::vector<uint8_t> payload;
+    std::vector<uint8_t> reply;
+
+    while (recvMessage(fd, type, payload)) {
+        if (type == MessageType::Shutdown) {
+            ::close(fd);
+            return 0;
+        }
+        if (type == MessageType::SceneData) {
+            Scene scene;
+            if (!deserializeScene(payload, scene))
+                break;
+            tracer = std::make_unique<RayTracer>(std::move(scene));
+        }
+        else if (type == MessageType::Frame) {
+            ByteReader r(payload.data(), payload.size());
+            if (!r.get(frame))
+                break;
+            renderSettings.width = frame.width;
+            renderSettings.height = frame.height;
+            renderSettings.tileSize = frame.tileSize;
+            renderSettings.samplesPerPixel = frame.samplesPerPixel;
+            renderSettings.firstSample = frame.firstSample;
+            renderSettings.shadows = frame.shadows != 0;
+            renderSettings.packets = frame.packets != 0;
+            renderSettings.seed = frame.seed;
+        }
+        else if (type == MessageType::Tile) {
+            ByteReader r(payload.data(), payload.size());
+            TileResultHeader result;
+            if (!tracer || !r.get(result.tile) || result.tile.frame != frame.frame)
+                break;
+            if (settings.exitAfterTiles >= 0 && tilesDone >= settings.exitAfterTiles)
+                break;      // Simulated crash: the tile never comes back
+            if (settings.tileDelaySeconds > 0.0)
+                std::this_thread::sleep_for(std::chrono::duration<double>(settings.tileDelaySeconds));
+
+            const Noise::TileRect rect{ result.tile.x0, result.tile.y0, result.tile.x1, result.tile.y1 };
+            const RenderStats stats = tracer->renderRegion(frame.pose.camera(), renderSettings, rect, image);
+            result.primaryRays = stats.primaryRays;
+            result.shadowRays = stats.shadowRays;
+            result.seconds = stats.seconds;
+
+            reply.clear();
+            ByteWriter w(reply);
+            w.put(result);
+            for (int y = rect.y0; y < rect.y1; ++y) {
+                for (int x = rect.x0; x < rect.x1; ++x)
+                    w.put(image.at(x, y));
+            }
+            if (!sendMessage(fd, MessageType::TileResult, reply))
+                break;
+            ++tilesDone;
+        }
+    }
+    ::close(fd);
+    return 1;
+}
+
+// -----------------------------
+// Local worker processes
+// -----------------------------
+LocalWorkers::~LocalWorkers() {
+    wait();
+}
+
+bool LocalWorkers::spawn(const std::string& executable, const std::vector<std::string>& args) {
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(executable.c_str()));
+    for (const std::string& arg : args)
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    const pid_t pid = ::fork();
+    if (pid < 0)
+        return false;
+    if (pid == 0) {
+        ::execv(executable.c_str(), argv.data());
+        ::_exit(127);
+    }
+    pids.push_back(static_cast<int>(pid));
+    return true;
+}
+
+void LocalWorkers::killAll() {
+    for (int pid : pids)
+        ::kill(static_cast<pid_t>(pid), SIGKILL);
+}
+
+void LocalWorkers::wait() {
+    for (int pid : pids)
+        ::waitpid(static_cast<pid_t>(pid), nullptr, 0);
+    pids.clear();
+}
+
+#else // _WIN32
+
+// -----------------------------
+// Not available: needs POSIX sockets and fork/exec
+// -----------------------------
+struct RenderCoordinator::State {};
+
+RenderCoordinator::RenderCoordinator(const CoordinatorSettings& settings)
+    : coordinator(settings), state(std::make_unique<State>()) {}
+RenderCoordinator::~RenderCoordinator() = default;
+
+bool RenderCoordinator::listen(const std::string&) {
+    lastError = "distributed rendering needs POSIX sockets (not available on Windows)";
+    return false;
+}
+int RenderCoordinator::acceptWorkers(int, double) { return 0; }
+int RenderCoordinator::workerCount() const { return 0; }
+void RenderCoordinator::setScene(const Scene&) {}
+DistributedStats RenderCoordinator::render(const Camera&, const RenderSettings&, Framebuffer&) {
+    lastError = "distributed rendering needs POSIX sockets (not available on Windows)";
+    return {};
+}
+
+int runRenderWorker(const std::string&, const WorkerSettings&) {
+    std::fprintf(stderr, "worker: distributed rendering needs POSIX sockets (not available on Windows)\n");
+    return 2;
+}
+
+LocalWorkers::~LocalWorkers() = default;
+bool LocalWorkers::spawn(const std::string&, const std::vector<std::string>&) { return false; }
+void LocalWorkers::killAll() {}
+void LocalWorkers::wait() {}
+
+#endif
@@ -0,0 +1,140 @@
+// DistributedRender.hpp
+// ---------------------------------------------------------
+// One ray traced frame across several processes or machines
+// Features:
+//  - Coordinator / worker over TCP ("tcp:HOST:PORT") or a Unix
+//    socket ("unix:PATH") for workers on the same box
+//  - The scene (triangles, meshes, instances, materials, noise
+//    patterns, fog volumes, light) is serialized once per worker, which
+//    bakes the patterns and fog grids itself; frames only send the
+//    camera and RenderSettings
+//  - Tiles are handed out on demand (a few in flight per worker)
+//    and copied into the coordinator's framebuffer as they return
+//  - Tiles of a worker that disconnects are re-queued; a tile that
+//    takes far longer than usual is re-issued to another worker
+//    and the first result wins
+//  - Local worker processes for testing on one machine
+// POSIX sockets; on Windows the calls fail with an error message.
+// ---------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Camera.hpp"
+#include "RayTracer.hpp"
+#include "Scene.hpp"
+
+// -----------------------------
+// Serialization (little-endian hosts, same float format on both ends)
+// -----------------------------
+void serializeScene(const Scene& scene, std::vector<uint8_t>& out);
+// False for malformed data and for scenes whose patterns or fog grids exceed
+// the worker's memory limits
+bool deserializeScene(const std::vector<uint8_t>& data, Scene& scene);
+
+// What a worker needs to rebuild the Camera's view and projection
+struct CameraPose {
+    glm::vec3 position = glm::vec3(0.0f, 2.0f, 8.0f);
+    glm::vec3 worldUp = glm::vec3(0.0f, 1.0f, 0.0f);
+    float yaw = -90.0f;
+    float pitch = 0.0f;
+    float zoom = 45.0f;
+
+    CameraPose() = default;
+    explicit CameraPose(const Camera& camera)
+        : position(camera.position), worldUp(camera.worldUp), yaw(camera.yaw), pitch(camera.pitch), zoom(camera.zoom) {}
+
+    Camera camera() const {
+        Camera c(position, worldUp, yaw, pitch);
+        c.zoom = zoom;
+        return c;
+    }
+};
+
+// -----------------------------
+// Coordinator
+// -----------------------------
+struct CoordinatorSettings {
+    int tilesInFlight = 2;          // Per worker, so a worker never waits for its next tile
+    double slowFactor = 8.0;        // Re-issue a tile running this many times the median tile time...
+    double minSlowSeconds = 0.25;   // ...but never before this
+    double workerTimeoutSeconds = 30.0; // No worker left / none connecting: give up
+};
+
+struct DistributedStats : RenderStats {
+    int workers = 0;                // Workers that took part in the frame
+    int tiles = 0;
+    int requeued = 0;               // Tiles of workers that disconnected
+    int reissued = 0;               // Slow tiles handed to a second worker
+    int duplicates = 0;             // Results that arrived after the tile was done
+    std::vector<int> tilesPerWorker;
+    bool complete = false;          // Every tile arrived
+};
+
+class RenderCoordinator {
+public:
+    explicit RenderCoordinator(const CoordinatorSettings& settings = {});
+    ~RenderCoordinator();   // Tells the workers to exit
+
+    RenderCoordinator(const RenderCoordinator&) = delete;
+    RenderCoordinator& operator=(const RenderCoordinator&) = delete;
+
+    // "tcp:PORT" (loopback), "tcp:HOST:PORT" or "unix:PATH". Port 0 picks a free port.
+    bool listen(const std::string& address);
+
+    // Address workers should connect to (the chosen port filled in)
+    const std::string& address() const { return boundAddress; }
+
+    // Waits until `count` workers are connected (or the timeout passes); returns the count
+    int acceptWorkers(int count, double timeoutSeconds);
+    int workerCount() const;
+
+    // Serialized once, sent to every worker now and to any that connects later
+    void setScene(const Scene& scene);
+
+    // Renders one frame on the workers into `target` (resized to settings.width x height)
+    DistributedStats render(const Camera& camera, const RenderSettings& settings, Framebuffer& target);
+
+    const std::string& error() const { return lastError; }
+
+    CoordinatorSettings coordinator;
+
+private:
+    struct State;
+    std::unique_ptr<State> state;
+    std::string boundAddress;
+    std::string lastError;
+};
+
+// -----------------------------
+// Worker
+// -----------------------------
+struct WorkerSettings {
+    int exitAfterTiles = -1;        // Testing: drop the connection instead of returning tile N + 1
+    double tileDelaySeconds = 0.0;  // Testing: act slow
+};
+
+// Connects to a coordinator and renders tiles until told to stop.
+// Returns 0 on a clean shutdown.
+int runRenderWorker(const std::string& address, const WorkerSettings& settings = {});
+
+// -----------------------------
+// Local worker processes (testing on one machine)
+// -----------------------------
+class LocalWorkers {
+public:
+    ~LocalWorkers();    // Waits for the workers (they exit when the coordinator goes away)
+
+    // Starts `executable args...` as a child process
+    bool spawn(const std::string& executable, const std::vector<std::string>& args);
+    void killAll();
+    void wait();
+    size_t size() const { return pids.size(); }
+
+private:
+    std::vector<int> pids;
+};
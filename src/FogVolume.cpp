@@ -0,0 +1,279 @@
+// FogVolume.cpp
+// ---------------------------------------------------------
+// Macro grid and ray marching (see FogVolume.hpp)
+// ---------------------------------------------------------
+
+#include "FogVolume.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+#include "Noise.hpp"
+#include "SimplexNoise.hpp"
+#include "ThreadPool.hpp"
+
+namespace {
+
+// Macro cells are sampled on a lattice with this many intervals per cell edge
+constexpr int samplesPerCellEdge = 4;
+
+// Marching stops once less than 1/1000 of the light behind gets through
+constexpr float opaqueDepth = 6.9f;
+
+// Macro cells along each axis: at least one, and no thinner than 1e-3
+glm::vec3 macroCells(const NoiseFog& fog) {
+    const glm::vec3 extent = glm::max(fog.boundsMax, fog.boundsMin + glm::vec3(1e-3f)) - fog.boundsMin;
+    return glm::max(glm::vec3(1.0f), glm::ceil(extent / std::max(fog.cellSize, 1e-3f)));
+}
+
+} // namespace
+
+FogVolume::FogVolume() = default;
+FogVolume::~FogVolume() = default;
+FogVolume::FogVolume(FogVolume&&) noexcept = default;
+FogVolume& FogVolume::operator=(FogVolume&&) noexcept = default;
+
+double FogVolume::cellCountFor(const NoiseFog& fog) {
+    const glm::vec3 cells = macroCells(fog);
+    return static_cast<double>(cells.x) * cells.y * cells.z;
+}
+
+FogVolume::FogVolume(const NoiseFog& settings)
+    : fog(settings),
+      generator(std::make_unique<Noise::SimplexNoise>(std::max(settings.seed, 0)))
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    fog.boundsMax = glm::max(fog.boundsMax, fog.boundsMin + glm::vec3(1e-3f));
+    fog.density = std::max(fog.density, 0.0f);
+    fog.coverage = std::clamp(fog.coverage, 0.0f, 0.999f);
+    fog.featureSize = std::max(fog.featureSize, 1e-3f);
+    fog.octaves = std::max(fog.octaves, 1);
+    fog.persistence = std::clamp(fog.persistence, 0.0f, 1.0f);
+    fog.lacunarity = std::max(fog.lacunarity, 1e-3f);
+    fog.cellSize = std::max(fog.cellSize, 1e-3f);
+    fog.fixedStep = std::max(fog.fixedStep, 1e-4f);
+    fog.stepOpticalDepth = std::max(fog.stepOpticalDepth, 1e-4f);
+
+    // Octave frequencies in cycles per world unit
+    maxAmplitude = Noise::fbm_octaves(fog.octaves, 1.0f / fog.featureSize, fog.persistence, fog.lacunarity, schedule);
+
+    const glm::vec3 extent = fog.boundsMax - fog.boundsMin;
+    cellCount = glm::ivec3(macroCells(fog));
+    cellSize = extent / glm::vec3(cellCount);
+
+    // -----------------------------
+    // fBm on the lattice, one z slice per task, rows through the batched (SIMD) noise
+    // -----------------------------
+    const glm::ivec3 lattice = cellCount * samplesPerCellEdge + 1;
+    const glm::vec3 spacing = cellSize / static_cast<float>(samplesPerCellEdge);
+    std::vector<float> values(static_cast<size_t>(lattice.x) * lattice.y * lattice.z);
+    Noise::ThreadPool& pool = Noise::ThreadPool::global();
+    pool.parallel_for(static_cast<size_t>(lattice.z), [&](size_t z) {
+        std::vector<float> xs(lattice.x), ys(lattice.x), zs(lattice.x), noise(lattice.x), sum(lattice.x);
+        const float pz = fog.boundsMin.z + static_cast<float>(z) * spacing.z;
+        for (int y = 0; y < lattice.y; ++y) {
+            const float py = fog.boundsMin.y + static_cast<float>(y) * spacing.y;
+            std::fill(sum.begin(), sum.end(), 0.0f);
+            for (const Noise::FbmOctave& octave : schedule) {
+                for (int x = 0; x < lattice.x; ++x) {
+                    xs[x] = (fog.boundsMin.x + static_cast<float>(x) * spacing.x) * octave.frequency;
+                    ys[x] = py * octave.frequency;
+                    zs[x] = pz * octave.frequency;
+                }
+                generator->noise3D_batch(xs.data(), ys.data(), zs.data(), noise.data(), lattice.x);
+                for (int x = 0; x < lattice.x; ++x)
+                    sum[x] += noise[x] * octave.amplitude;
+            }
+            float* row = values.data() + (z * lattice.y + y) * static_cast<size_t>(lattice.x);
+            for (int x = 0; x < lattice.x; ++x)
+                row[x] = sum[x] / maxAmplitude * 0.5f + 0.5f;
+        }
+    });
+
+    // Peaks between lattice samples: a point is at most sqrt(3)/2 h from a sample,
+    // and an octave of amplitude A and period P rises at most A (1 - cos(sqrt(3) pi h / P))
+    // above it if it varies no faster than a sinusoid of that period. That is an
+    // estimate, not a bound: simplex gradients reach ~8.5 per lattice unit, and a
+    // Lipschitz margin from them (~0.4 here) would leave no cell empty. Over dense
+    // samples the real excess stays ~4x below this margin; --fog-bench checks the error.
+    const float h = std::max({ spacing.x, spacing.y, spacing.z });
+    float margin = 0.0f;
+    for (const Noise::FbmOctave& octave : schedule) {
+        const float amplitude = 0.5f * octave.amplitude / maxAmplitude;
+        const float phase = std::min(std::sqrt(3.0f) * std::numbers::pi_v<float> * h * octave.frequency, std::numbers::pi_v<float>);
+        margin += amplitude * (1.0f - std::cos(phase));
+    }
+
+    // -----------------------------
+    // Min / max per cell over its (samplesPerCellEdge + 1)^3 lattice points
+    // -----------------------------
+    cells.resize(static_cast<size_t>(cellCount.x) * cellCount.y * cellCount.z);
+    pool.parallel_for(static_cast<size_t>(cellCount.z), [&](size_t cz) {
+        for (int cy = 0; cy < cellCount.y; ++cy) {
+            for (int cx = 0; cx < cellCount.x; ++cx) {
+                float lo = std::numeric_limits<float>::max(), hi = std::numeric_limits<float>::lowest();
+                for (int dz = 0; dz <= samplesPerCellEdge; ++dz) {
+                    for (int dy = 0; dy <= samplesPerCellEdge; ++dy) {
+                        const size_t z = cz * samplesPerCellEdge + dz, y = static_cast<size_t>(cy) * samplesPerCellEdge + dy;
+                        const float* row = values.data() + (z * lattice.y + y) * static_cast<size_t>(lattice.x)
+                                         + static_cast<size_t>(cx) * samplesPerCellEdge;
+                        for (int dx = 0; dx <= samplesPerCellEdge; ++dx) {
+                            lo = std::min(lo, row[dx]);
+                            hi = std::max(hi, row[dx]);
+                        }
+                    }
+                }
+                // Density falls with height: the max sits at the cell's bottom, the min at its top
+                const float bottom = fog.boundsMin.y + static_cast<float>(cy) * cellSize.y;
+                Cell& c = cells[(cz * cellCount.y + cy) * static_cast<size_t>(cellCount.x) + cx];
+                c.maxDensity = densityFromNoise(hi + margin, bottom);
+                c.minDensity = densityFromNoise(lo - margin, bottom + cellSize.y);
+            }
+        }
+    });
+
+    buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+float FogVolume::noiseValue(const glm::vec3& point) const {
+    float sum = 0.0f;
+    for (const Noise::FbmOctave& octave : schedule)
+        sum += generator->noise3D(point.x * octave.frequency, point.y * octave.frequency, point.z * octave.frequency) * octave.amplitude;
+    return sum / maxAmplitude * 0.5f + 0.5f;
+}
+
+float FogVolume::densityFromNoise(float noise, float y) const {
+    // The threshold rises from `coverage` at the bottom to 1 at the top: only the
+    // highest noise peaks reach up, and the air above them is empty
+    const float height = std::clamp((y - fog.boundsMin.y) / (fog.boundsMax.y - fog.boundsMin.y), 0.0f, 1.0f);
+    const float threshold = fog.coverage + (1.0f - fog.coverage) * height;
+    return fog.density * std::max(noise - threshold, 0.0f) / (1.0f - fog.coverage);
+}
+
+float FogVolume::density(const glm::vec3& point) const {
+    return densityFromNoise(noiseValue(point), point.y);
+}
+
+bool FogVolume::clip(const glm::vec3& origin, const glm::vec3& direction, float tEnd, float& t0, float& t1) const {
+    t0 = 0.0f;
+    t1 = tEnd;
+    for (int a = 0; a < 3; ++a) {
+        const float inv = 1.0f / direction[a];
+        float tNear = (fog.boundsMin[a] - origin[a]) * inv;
+        float tFar = (fog.boundsMax[a] - origin[a]) * inv;
+        if (tNear > tFar)
+            std::swap(tNear, tFar);
+        // NaN (ray in the slab's plane) leaves the range as it is
+        t0 = tNear > t0 ? tNear : t0;
+        t1 = tFar < t1 ? tFar : t1;
+    }
+    return t0 < t1;
+}
+
+void FogVolume::count(uint64_t samples, uint64_t visited, uint64_t empty) const {
+    counters.add(Rays);
+    counters.add(Samples, samples);
+    counters.add(Cells, visited);
+    counters.add(EmptyCells, empty);
+}
+
+glm::vec3 FogVolume::march(const glm::vec3& origin, const glm::vec3& direction, float tEnd, const glm::vec3& behind,
+                           FogMarch mode) const {
+    float t0, t1;
+    if (!clip(origin, direction, tEnd, t0, t1))
+        return behind;
+
+    // The fog's color is constant, so only the optical depth needs integrating:
+    // what the fog scatters towards the eye is color * (1 - transmittance)
+    float depth = 0.0f;
+    uint64_t samples = 0, visited = 0, empty = 0;
+    auto integrate = [&](float from, float length, int steps) {
+        const float step = length / static_cast<float>(steps);
+        for (int i = 0; i < steps && depth < opaqueDepth; ++i) {
+            depth += density(origin + direction * (from + (static_cast<float>(i) + 0.5f) * step)) * step;
+            ++samples;
+        }
+    };
+
+    if (mode == FogMarch::FixedStep) {
+        integrate(t0, t1 - t0, std::max(1, static_cast<int>(std::ceil((t1 - t0) / fog.fixedStep))));
+    }
+    else {
+        // 3D DDA through the macro cells from the entry point
+        const glm::vec3 entry = origin + direction * t0;
+        glm::ivec3 c = glm::clamp(glm::ivec3(glm::floor((entry - fog.boundsMin) / cellSize)), glm::ivec3(0), cellCount - 1);
+        glm::ivec3 step(0);
+        glm::vec3 tNext(std::numeric_limits<float>::infinity());
+        glm::vec3 tDelta(std::numeric_limits<float>::infinity());
+        for (int a = 0; a < 3; ++a) {
+            if (direction[a] > 0.0f) {
+                step[a] = 1;
+                tNext[a] = (fog.boundsMin[a] + static_cast<float>(c[a] + 1) * cellSize[a] - origin[a]) / direction[a];
+                tDelta[a] = cellSize[a] / direction[a];
+            }
+            else if (direction[a] < 0.0f) {
+                step[a] = -1;
+                tNext[a] = (fog.boundsMin[a] + static_cast<float>(c[a]) * cellSize[a] - origin[a]) / direction[a];
+                tDelta[a] = -cellSize[a] / direction[a];
+            }
+        }
+
+        float t = t0;
+        while (t < t1 && depth < opaqueDepth) {
+            const int axis = tNext.x < tNext.y ? (tNext.x < tNext.z ? 0 : 2) : (tNext.y < tNext.z ? 1 : 2);
+            const float tExit = std::min(tNext[axis], t1);
+            const float length = tExit - t;
+            const Cell& cellBounds = cell(c.x, c.y, c.z);
+            ++visited;
+            if (cellBounds.maxDensity <= 0.0f) {
+                ++empty;
+            }
+            else if (length > 0.0f) {
+                // Each step carries at most stepOpticalDepth; a cell whose density spread
+                // over the segment is below that needs a single sample
+                int steps = 1;
+                if ((cellBounds.maxDensity - cellBounds.minDensity) * length > fog.stepOpticalDepth) {
+                    const float stepLength = std::max(fog.fixedStep, fog.stepOpticalDepth / cellBounds.maxDensity);
+                    steps = std::max(1, static_cast<int>(std::ceil(length / stepLength)));
+                }
+                integrate(t, length, steps);
+            }
+            if (tExit >= t1)
+                break;
+            t = tExit;
+            c[axis] += step[axis];
+            if (c[axis] < 0 || c[axis] >= cellCount[axis])
+                break;
+            tNext[axis] += tDelta[axis];
+        }
+    }
+
+    count(samples, visited, empty);
+    const float transmittance = std::exp(-depth);
+    return fog.color * (1.0f - transmittance) + behind * transmittance;
+}
+
+FogStats FogVolume::stats() const {
+    FogStats stats;
+    stats.rays = counters.total(Rays);
+    stats.samples = counters.total(Samples);
+    stats.cells = counters.total(Cells);
+    stats.emptyCells = counters.total(EmptyCells);
+    stats.cellsX = cellCount.x;
+    stats.cellsY = cellCount.y;
+    stats.cellsZ = cellCount.z;
+    const size_t emptyCount = static_cast<size_t>(std::count_if(cells.begin(), cells.end(),
+                                                                [](const Cell& c) { return c.maxDensity <= 0.0f; }));
+    stats.emptyFraction = cells.empty() ? 0.0 : static_cast<double>(emptyCount) / static_cast<double>(cells.size());
+    stats.bytes = cells.size() * sizeof(Cell);
+    stats.buildSeconds = buildSeconds;
+    return stats;
+}
+
+void FogVolume::resetStats() const {
+    counters.reset();
+}
@@ -0,0 +1,108 @@
+// FogVolume.hpp
+// ---------------------------------------------------------
+// Ray-marched noise fog (a NoiseFog from the Scene)
+// Features:
+//  - Density = 3D simplex fBm above a threshold that rises from the
+//    coverage at the bottom of the fog box to 1 at its top
+//  - Macro grid: min / max density per coarse cell, built once on
+//    the RelNo_D1 thread pool from a lattice of batched (SIMD)
+//    noise samples plus a margin for peaks between the samples.
+//    The margin is an estimate, not a bound, so empty-space skipping
+//    is approximate: a peak it underestimates can be skipped.
+//    --fog-bench fails when the adaptive error grows past 1/1024.
+//  - Adaptive marching walks the macro grid (3D DDA): empty cells
+//    are skipped, steps grow where the cell's max density is low,
+//    and cells that barely vary are crossed in one step
+//  - Fixed-step marching for comparison
+//  - Emission / absorption: the fog scatters its color towards the
+//    eye and attenuates what lies behind it (no shadowing of the light)
+// ---------------------------------------------------------
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Fbm.hpp"
+#include "Scene.hpp"
+#include "ShardedCounter.hpp"
+
+namespace Noise { class SimplexNoise; }
+
+enum class FogMarch {
+    Adaptive,   // Macro grid: empty-space skipping and adaptive steps
+    FixedStep   // NoiseFog::fixedStep everywhere inside the box
+};
+
+struct FogStats {
+    uint64_t rays = 0;          // Rays that crossed the fog box
+    uint64_t samples = 0;       // Density evaluations
+    uint64_t cells = 0;         // Macro cells visited (adaptive)
+    uint64_t emptyCells = 0;    // Of those, skipped without sampling
+    int cellsX = 0, cellsY = 0, cellsZ = 0;
+    double emptyFraction = 0.0; // Macro cells with zero max density
+    size_t bytes = 0;           // Macro grid
+    double buildSeconds = 0.0;
+
+    double samplesPerRay() const { return rays > 0 ? static_cast<double>(samples) / static_cast<double>(rays) : 0.0; }
+};
+
+class FogVolume {
+public:
+    FogVolume();
+    ~FogVolume();
+    FogVolume(FogVolume&&) noexcept;
+    FogVolume& operator=(FogVolume&&) noexcept;
+
+    // Builds the macro grid (on the RelNo_D1 thread pool)
+    explicit FogVolume(const NoiseFog& fog);
+
+    // Macro cells the grid for `fog` has (its build memory grows with this);
+    // infinite for an unbounded box
+    static double cellCountFor(const NoiseFog& fog);
+
+    // Extinction per world unit at `point`
+    float density(const glm::vec3& point) const;
+
+    // Parametric range [t0, t1] of the ray inside the fog box, cut at tEnd
+    // (the first surface); false when the ray misses the box
+    bool clip(const glm::vec3& origin, const glm::vec3& direction, float tEnd, float& t0, float& t1) const;
+
+    // `behind` seen through the fog between the ray origin and tEnd
+    glm::vec3 march(const glm::vec3& origin, const glm::vec3& direction, float tEnd, const glm::vec3& behind,
+                    FogMarch mode) const;
+
+    const NoiseFog& settings() const { return fog; }
+
+    FogStats stats() const;
+    void resetStats() const;
+
+private:
+    struct Cell {
+        float minDensity = 0.0f;
+        float maxDensity = 0.0f;
+    };
+
+    // March counters (one cache line per thread, see ShardedCounter.hpp)
+    enum Counter { Rays, Samples, Cells, EmptyCells, CounterCount };
+
+    float noiseValue(const glm::vec3& point) const;     // fBm in [0,1]
+    float densityFromNoise(float noise, float y) const;
+    const Cell& cell(int x, int y, int z) const { return cells[(static_cast<size_t>(z) * cellCount.y + y) * cellCount.x + x]; }
+    void count(uint64_t samples, uint64_t visited, uint64_t empty) const;
+
+    NoiseFog fog;
+    glm::ivec3 cellCount = glm::ivec3(0);
+    glm::vec3 cellSize = glm::vec3(1.0f);
+    std::vector<Cell> cells;            // x fastest, then y, then z
+    double buildSeconds = 0.0;
+
+    std::unique_ptr<Noise::SimplexNoise> generator;
+    std::vector<Noise::FbmOctave> schedule;
+    float maxAmplitude = 1.0f;
+
+    ShardedCounter<CounterCount> counters;
+};
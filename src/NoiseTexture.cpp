@@ -0,0 +1,164 @@
+// NoiseTexture.cpp
+// ---------------------------------------------------------
+// Baking and filtered lookups (see NoiseTexture.hpp)
+// ---------------------------------------------------------
+
+#include "NoiseTexture.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+
+#include "Noise.hpp"
+#include "NoisePyramid.hpp"
+#include "PerlinNoise.hpp"
+#include "ThreadPool.hpp"
+
+namespace {
+
+// Spreads the low 16 bits of v to the even bit positions
+uint32_t spreadBits(uint32_t v) {
+    v &= 0x0000FFFFu;
+    v = (v | (v << 8)) & 0x00FF00FFu;
+    v = (v | (v << 4)) & 0x0F0F0F0Fu;
+    v = (v | (v << 2)) & 0x33333333u;
+    v = (v | (v << 1)) & 0x55555555u;
+    return v;
+}
+
+// Exponent plus linear mantissa: exact at powers of two, at most 0.09 low in
+// between, which only shifts the blend between two levels a little
+float approxLog2(float x) {
+    const uint32_t bits = std::bit_cast<uint32_t>(x);
+    const float mantissa = static_cast<float>(bits & 0x007FFFFFu) * (1.0f / 8388608.0f);
+    return static_cast<float>(static_cast<int>(bits >> 23) - 127) + mantissa;
+}
+
+} // namespace
+
+NoiseTexture::NoiseTexture() = default;
+NoiseTexture::~NoiseTexture() = default;
+NoiseTexture::NoiseTexture(NoiseTexture&&) noexcept = default;
+NoiseTexture& NoiseTexture::operator=(NoiseTexture&&) noexcept = default;
+
+int NoiseTexture::sizeFor(int resolution) {
+    // Morton indices use 16 bits per axis; 8192^2 floats is already 256 MB
+    return static_cast<int>(std::bit_ceil(static_cast<uint32_t>(std::clamp(resolution, 2, 8192))));
+}
+
+NoiseTexture::NoiseTexture(const NoisePattern& settings)
+    : pattern(settings),
+      generator(std::make_unique<Noise::PerlinNoise>(std::max(settings.seed, 0)))
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    size = sizeFor(pattern.resolution);
+    pattern.extent = std::max(pattern.extent, 1e-6f);
+    pattern.featureSize = std::max(pattern.featureSize, 1e-6f);
+    pattern.octaves = std::max(pattern.octaves, 1);
+    pattern.persistence = std::clamp(pattern.persistence, 0.0f, 1.0f);
+    pattern.lacunarity = std::max(pattern.lacunarity, 1e-6f);
+
+    // Texel 0 sits on the window's corner and texel size - 1 on the opposite one
+    texelsPerUnit = static_cast<float>(size - 1) / pattern.extent;
+    scale = pattern.featureSize * texelsPerUnit;
+    maxAmplitude = Noise::fbm_octaves(pattern.octaves, 1.0f, pattern.persistence, pattern.lacunarity, schedule);
+
+    const int levels = Noise::max_pyramid_levels(size, size);
+    const Noise::NoisePyramid pyramid = Noise::generate_perlin_pyramid2d(
+        size, size, levels, scale, pattern.octaves, 1.0f, pattern.persistence, pattern.lacunarity, 0.0f, std::max(pattern.seed, 0));
+
+    // Levels back to back, each starting on a cache line
+    size_t total = 0;
+    for (int k = 0; k < levels; ++k) {
+        levelOffsets.push_back(total);
+        const size_t edge = static_cast<size_t>(Noise::pyramid_level_size(size, k));
+        total += (edge * edge + 15) & ~static_cast<size_t>(15);
+    }
+    texels.assign(total + 15, 0.0f);
+    alignment = static_cast<size_t>((64 - reinterpret_cast<uintptr_t>(texels.data()) % 64) % 64) / sizeof(float);
+
+    for (int k = 0; k < levels; ++k) {
+        const Noise::NoiseMap2D& source = pyramid.levels[k];
+        float* target = texels.data() + alignment + levelOffsets[k];
+        const int edge = source.width();
+        Noise::ThreadPool::global().parallel_for(static_cast<size_t>(edge), [&](size_t y) {
+            const float* row = source.row(static_cast<int>(y));
+            const uint32_t my = spreadBits(static_cast<uint32_t>(y)) << 1;
+            for (int x = 0; x < edge; ++x)
+                target[spreadBits(static_cast<uint32_t>(x)) | my] = row[x];
+        });
+    }
+
+    bakeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+float NoiseTexture::bilinear(int k, float x, float y) const {
+    const int last = (size >> k) - 1;
+    x = std::clamp(x, 0.0f, static_cast<float>(last));
+    y = std::clamp(y, 0.0f, static_cast<float>(last));
+    const int x0 = static_cast<int>(x), y0 = static_cast<int>(y);
+    const float fx = x - static_cast<float>(x0), fy = y - static_cast<float>(y0);
+
+    // One spread per axis; the +1 neighbour is a Morton increment (carry through
+    // the other axis' bits), held at the last texel
+    const uint32_t mx0 = spreadBits(static_cast<uint32_t>(x0));
+    const uint32_t my0 = spreadBits(static_cast<uint32_t>(y0)) << 1;
+    const uint32_t mx1 = x0 < last ? ((mx0 | 0xAAAAAAAAu) + 1u) & 0x55555555u : mx0;
+    const uint32_t my1 = y0 < last ? ((my0 | 0x55555555u) + 2u) & 0xAAAAAAAAu : my0;
+
+    const float* t = level(k);
+    const float top = t[mx0 | my0] + (t[mx1 | my0] - t[mx0 | my0]) * fx;
+    const float bottom = t[mx0 | my1] + (t[mx1 | my1] - t[mx0 | my1]) * fx;
+    return top + (bottom - top) * fy;
+}
+
+float NoiseTexture::sample(const glm::vec2& point, float footprint) const {
+    counters.add(Lookups);
+
+    const float x = (point.x - pattern.origin.x) * texelsPerUnit;
+    const float y = (point.y - pattern.origin.y) * texelsPerUnit;
+    const float last = static_cast<float>(size - 1);
+    if (!(x >= 0.0f && y >= 0.0f && x <= last && y <= last)) {
+        counters.add(Misses);
+        return evaluate(point);
+    }
+
+    // Level where one texel covers the footprint; blend the two around it
+    const float footprintTexels = footprint * texelsPerUnit;
+    const float lod = footprintTexels > 1.0f ? std::min(approxLog2(footprintTexels), static_cast<float>(levelCount() - 1)) : 0.0f;
+    const int k = static_cast<int>(lod);
+    const float blend = lod - static_cast<float>(k);
+    const float step = 1.0f / static_cast<float>(1 << k);    // Level k texel j is level 0 texel j * 2^k
+    const float fine = bilinear(k, x * step, y * step);
+    if (blend <= 0.0f)
+        return fine;
+    const float coarse = bilinear(k + 1, x * step * 0.5f, y * step * 0.5f);
+    return fine + (coarse - fine) * blend;
+}
+
+float NoiseTexture::evaluate(const glm::vec2& point) const {
+    // Same sample positions as generate_perlin_map: (texel + base) / scale * frequency
+    const float x = (point.x - pattern.origin.x) * texelsPerUnit;
+    const float y = (point.y - pattern.origin.y) * texelsPerUnit;
+    float sum = 0.0f;
+    for (const Noise::FbmOctave& octave : schedule)
+        sum += generator->noise(x / scale * octave.frequency, y / scale * octave.frequency) * octave.amplitude;
+    return sum / maxAmplitude;
+}
+
+NoiseTextureStats NoiseTexture::stats() const {
+    NoiseTextureStats stats;
+    stats.lookups = counters.total(Lookups);
+    stats.misses = counters.total(Misses);
+    stats.bytes = levelOffsets.empty() ? 0 : (texels.size() - 15) * sizeof(float);
+    stats.levels = levelCount();
+    stats.resolution = size;
+    stats.bakeSeconds = bakeSeconds;
+    return stats;
+}
+
+void NoiseTexture::resetStats() const {
+    counters.reset();
+}
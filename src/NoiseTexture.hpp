@@ -0,0 +1,91 @@
+// NoiseTexture.hpp
+// ---------------------------------------------------------
+// A NoisePattern baked once into a pre-filtered mip pyramid
+// Features:
+//  - Levels come from RelNo_D1's generate_perlin_pyramid2d: each
+//    coarser level drops the octaves above its Nyquist limit, so
+//    the mips are band-limited instead of box-averaged
+//  - Every level is stored in Morton (Z) order: a 4x4 texel block
+//    is one cache line and a bilinear footprint touches one or two
+//  - Trilinear lookups; the level comes from the hit's pixel
+//    footprint (primary ray differentials, see CameraRays)
+//  - Points outside the baked window fall back to the exact fBm
+//  - Counters: lookups served by the texture vs evaluated (the hit
+//    rate) and the bytes the levels occupy
+// ---------------------------------------------------------
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Fbm.hpp"
+#include "Scene.hpp"
+#include "ShardedCounter.hpp"
+
+namespace Noise { class PerlinNoise; }
+
+struct NoiseTextureStats {
+    uint64_t lookups = 0;       // sample() calls
+    uint64_t misses = 0;        // Outside the baked window: fBm evaluated instead
+    size_t bytes = 0;           // Texels of every level
+    int levels = 0;
+    int resolution = 0;         // Texels per side of level 0
+    double bakeSeconds = 0.0;
+
+    double hitRate() const { return lookups > 0 ? static_cast<double>(lookups - misses) / static_cast<double>(lookups) : 0.0; }
+};
+
+class NoiseTexture {
+public:
+    NoiseTexture();
+    ~NoiseTexture();
+    NoiseTexture(NoiseTexture&&) noexcept;
+    NoiseTexture& operator=(NoiseTexture&&) noexcept;
+
+    // Bakes every level (on the RelNo_D1 thread pool)
+    explicit NoiseTexture(const NoisePattern& pattern);
+
+    // Texels per side of the finest level baked for `resolution`
+    static int sizeFor(int resolution);
+
+    // Pattern value in [0,1] at `point` on the projection plane. `footprint` is the
+    // world-space size of the pixel there (0 = finest level).
+    float sample(const glm::vec2& point, float footprint) const;
+
+    // The pattern's fBm evaluated directly (what every lookup would cost unbaked)
+    float evaluate(const glm::vec2& point) const;
+
+    // One bilinear lookup in `level`, in that level's texel coordinates
+    float bilinear(int level, float x, float y) const;
+
+    int levelCount() const { return static_cast<int>(levelOffsets.size()); }
+    int resolution() const { return size; }
+
+    NoiseTextureStats stats() const;
+    void resetStats() const;
+
+private:
+    // Lookup counters (one cache line per thread, see ShardedCounter.hpp)
+    enum Counter { Lookups, Misses, CounterCount };
+
+    const float* level(int k) const { return texels.data() + alignment + levelOffsets[k]; }
+
+    NoisePattern pattern;
+    int size = 0;                       // Power of two
+    float texelsPerUnit = 0.0f;         // Level 0 texels per world unit
+    float scale = 1.0f;                 // First-octave period in texels (generate_perlin_map's scale)
+    std::vector<float> texels;          // All levels, Morton order each
+    size_t alignment = 0;               // Floats skipped so level 0 starts on a cache line
+    std::vector<size_t> levelOffsets;   // First texel of each level, in floats
+    double bakeSeconds = 0.0;
+
+    std::unique_ptr<Noise::PerlinNoise> generator;
+    std::vector<Noise::FbmOctave> schedule;
+    float maxAmplitude = 1.0f;
+
+    ShardedCounter<CounterCount> counters;
+};
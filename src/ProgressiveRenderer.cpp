@@ -0,0 +1,64 @@
+// ProgressiveRenderer.cpp
+// ---------------------------------------------------------
+// Accumulation and restart logic (see ProgressiveRenderer.hpp)
+// ---------------------------------------------------------
+
+#include "ProgressiveRenderer.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "ThreadPool.hpp"
+
+void ProgressiveRenderer::reset() {
+    sampleCount = 0;
+}
+
+RenderStats ProgressiveRenderer::step(const RayTracer& tracer, const Camera& camera, const RenderSettings& settings) {
+    const int width = std::max(settings.width, 1);
+    const int height = std::max(settings.height, 1);
+    if (width != average.width || height != average.height) {
+        average.resize(width, height);
+        sum.assign(average.pixels.size(), glm::vec3(0.0f));
+        sampleCount = 0;
+    }
+    if (camera.viewVersion != cameraVersion) {
+        cameraVersion = camera.viewVersion;
+        sampleCount = 0;
+    }
+
+    RenderStats frame;
+    frame.threads = Noise::thread_count();
+    if (converged())
+        return frame;
+
+    const auto start = std::chrono::steady_clock::now();
+    RenderSettings passSettings = settings;
+    passSettings.width = width;
+    passSettings.height = height;
+    passSettings.samplesPerPixel = 1;
+
+    for (int i = 0; i < std::max(progressive.maxSamplesPerFrame, 1) && !converged(); ++i) {
+        passSettings.firstSample = sampleCount;
+        const RenderStats stats = tracer.render(camera, passSettings, pass);
+        frame.primaryRays += stats.primaryRays;
+        frame.shadowRays += stats.shadowRays;
+
+        // The first pass replaces what is left of a previous view
+        const float weight = 1.0f / static_cast<float>(sampleCount + 1);
+        const bool restart = sampleCount == 0;
+        Noise::ThreadPool::global().parallel_for(height, [&](size_t y) {
+            const size_t row = y * static_cast<size_t>(width);
+            for (size_t p = row; p < row + static_cast<size_t>(width); ++p) {
+                sum[p] = restart ? pass.pixels[p] : sum[p] + pass.pixels[p];
+                average.pixels[p] = sum[p] * weight;
+            }
+        });
+        ++sampleCount;
+
+        frame.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (frame.seconds >= progressive.frameBudgetSeconds)
+            break;
+    }
+    return frame;
+}
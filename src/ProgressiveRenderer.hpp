@@ -0,0 +1,53 @@
+// ProgressiveRenderer.hpp
+// ---------------------------------------------------------
+// Progressive ray tracing for the interactive view
+// Features:
+//  - Float accumulation buffer: every frame adds samples and
+//    the displayed image is the running average
+//  - Bounded work per frame (time budget + sample cap), so the
+//    window stays responsive while the image converges
+//  - Restarts when Camera::viewVersion, the image size or the
+//    scene (reset()) changes
+// ---------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Camera.hpp"
+#include "RayTracer.hpp"
+
+struct ProgressiveSettings {
+    double frameBudgetSeconds = 0.025;  // Stop adding passes once a frame has used this much time
+    int maxSamplesPerFrame = 16;        // Hard cap on passes per frame
+    int maxSamples = 4096;              // Converged: stop tracing after this many samples per pixel
+};
+
+class ProgressiveRenderer {
+public:
+    explicit ProgressiveRenderer(const ProgressiveSettings& settings = {}) : progressive(settings) {}
+
+    // Drop the accumulated samples (call when the scene changes)
+    void reset();
+
+    // Adds at least one sample per pixel, more while the frame budget lasts.
+    // settings.width / height set the image size; settings.samplesPerPixel
+    // and firstSample are managed here. Returns the work done this frame.
+    RenderStats step(const RayTracer& tracer, const Camera& camera, const RenderSettings& settings);
+
+    // Running average of all samples so far (linear RGB, row 0 at the top)
+    const Framebuffer& image() const { return average; }
+
+    int samples() const { return sampleCount; }
+    bool converged() const { return sampleCount >= progressive.maxSamples; }
+
+    ProgressiveSettings progressive;
+
+private:
+    std::vector<glm::vec3> sum;     // Sum of all samples per pixel
+    Framebuffer pass;               // One-sample pass, added into sum
+    Framebuffer average;
+    int sampleCount = 0;
+    unsigned int cameraVersion = 0;
+};
@@ -0,0 +1,119 @@
+// RayPacket.cpp
+// ---------------------------------------------------------
+// Triangle SoA layout, scalar packet fallback and the runtime
+// choice between the SSE2 / AVX2 kernels (see RayPacket.hpp)
+// ---------------------------------------------------------
+
+#include "RayPacketKernels.hpp"
+
+#include <cmath>
+
+#include "SimdDispatch.hpp"
+
+namespace {
+
+// Same test as the SIMD kernels, one lane at a time
+float intersectSoA(const TriangleSoA& tris, uint32_t i, const glm::vec3& o, const glm::vec3& d, float tMin, float tMax) {
+    const glm::vec3 e1(tris.e1x[i], tris.e1y[i], tris.e1z[i]);
+    const glm::vec3 e2(tris.e2x[i], tris.e2y[i], tris.e2z[i]);
+    const glm::vec3 p = glm::cross(d, e2);
+    const float det = glm::dot(e1, p);
+    if (std::fabs(det) < 1e-8f)
+        return std::numeric_limits<float>::infinity();
+
+    const float invDet = 1.0f / det;
+    const glm::vec3 s = o - glm::vec3(tris.v0x[i], tris.v0y[i], tris.v0z[i]);
+    const float u = glm::dot(s, p) * invDet;
+    if (u < 0.0f || u > 1.0f)
+        return std::numeric_limits<float>::infinity();
+
+    const glm::vec3 q = glm::cross(s, e1);
+    const float v = glm::dot(d, q) * invDet;
+    if (v < 0.0f || u + v > 1.0f)
+        return std::numeric_limits<float>::infinity();
+
+    const float t = glm::dot(e2, q) * invDet;
+    return (t > tMin && t < tMax) ? t : std::numeric_limits<float>::infinity();
+}
+
+} // namespace
+
+void TriangleSoA::build(const std::vector<Triangle>& triangles) {
+    const size_t n = triangles.size();
+    for (std::vector<float>* array : { &v0x, &v0y, &v0z, &e1x, &e1y, &e1z, &e2x, &e2y, &e2z })
+        array->resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        const Triangle& tri = triangles[i];
+        const glm::vec3 e1 = tri.v1 - tri.v0;
+        const glm::vec3 e2 = tri.v2 - tri.v0;
+        v0x[i] = tri.v0.x; v0y[i] = tri.v0.y; v0z[i] = tri.v0.z;
+        e1x[i] = e1.x; e1y[i] = e1.y; e1z[i] = e1.z;
+        e2x[i] = e2.x; e2y[i] = e2.y; e2z[i] = e2.z;
+    }
+}
+
+// -----------------------------
+// Scalar fallback
+// -----------------------------
+void intersectPacketScalar(const Bvh& bvh, const TriangleSoA& triangles, const RayPacket8& packet, PacketHit8& hit) {
+    for (int lane = 0; lane < packetWidth; ++lane) {
+        hit.t[lane] = std::numeric_limits<float>::infinity();
+        hit.triangle[lane] = -1;
+        if (!(packet.active & (1u << lane)))
+            continue;
+        const glm::vec3 o(packet.ox[lane], packet.oy[lane], packet.oz[lane]);
+        const glm::vec3 d(packet.dx[lane], packet.dy[lane], packet.dz[lane]);
+        const float tMin = packet.tMin[lane];
+        int32_t& triangle = hit.triangle[lane];
+        hit.t[lane] = bvh.traverse(o, d, tMin, packet.tMax[lane], [&](uint32_t i, float closest) {
+            const float t = intersectSoA(triangles, i, o, d, tMin, closest);
+            if (t < closest)
+                triangle = static_cast<int32_t>(i);
+            return t;
+        });
+    }
+}
+
+uint32_t occludedPacketScalar(const Bvh& bvh, const TriangleSoA& triangles, const RayPacket8& packet) {
+    uint32_t blocked = 0;
+    for (int lane = 0; lane < packetWidth; ++lane) {
+        if (!(packet.active & (1u << lane)))
+            continue;
+        const glm::vec3 o(packet.ox[lane], packet.oy[lane], packet.oz[lane]);
+        const glm::vec3 d(packet.dx[lane], packet.dy[lane], packet.dz[lane]);
+        const float tMin = packet.tMin[lane];
+        const float tMax = packet.tMax[lane];
+        if (bvh.traverseAny(o, d, tMin, tMax, [&](uint32_t i) { return intersectSoA(triangles, i, o, d, tMin, tMax) < tMax; }))
+            blocked |= 1u << lane;
+    }
+    return blocked;
+}
+
+// -----------------------------
+// Dispatch
+// -----------------------------
+void intersectPacket(const Bvh& bvh, const TriangleSoA& triangles, const RayPacket8& packet, PacketHit8& hit) {
+    switch (Noise::active_simd_level()) {
+    case Noise::SimdLevel::AVX2:
+        intersectPacketAVX2(bvh, triangles, packet, hit);
+        break;
+    case Noise::SimdLevel::SSE2:
+        intersectPacketSSE(bvh, triangles, packet, hit);
+        break;
+    case Noise::SimdLevel::Scalar:
+        intersectPacketScalar(bvh, triangles, packet, hit);
+        break;
+    }
+}
+
+uint32_t occludedPacket(const Bvh& bvh, const TriangleSoA& triangles, const RayPacket8& packet) {
+    switch (Noise::active_simd_level()) {
+    case Noise::SimdLevel::AVX2:
+        return occludedPacketAVX2(bvh, triangles, packet);
+    case Noise::SimdLevel::SSE2:
+        return occludedPacketSSE(bvh, triangles, packet);
+    case Noise::SimdLevel::Scalar:
+        break;
+    }
+    return occludedPacketScalar(bvh, triangles, packet);
+}
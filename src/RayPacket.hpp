@@ -0,0 +1,74 @@
+// RayPacket.hpp
+// ---------------------------------------------------------
+// 8-wide ray packets for coherent primary and shadow rays
+// Features:
+//  - Packet-vs-AABB slab tests while walking the BVH
+//  - Moller-Trumbore against triangles stored structure-of-arrays
+//  - Per-lane active masks: subtrees and triangles no live lane
+//    can hit are skipped, finished shadow lanes drop out
+//  - AVX2 (8 lanes) and SSE2 (2 x 4 lanes) kernels, picked at runtime
+//    through RelNo_D1's SIMD dispatch; scalar fallback elsewhere
+// ---------------------------------------------------------
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "Bvh.hpp"
+#include "Scene.hpp"
+
+constexpr int packetWidth = 8;
+
+struct alignas(32) RayPacket8 {
+    float ox[packetWidth], oy[packetWidth], oz[packetWidth];
+    float dx[packetWidth], dy[packetWidth], dz[packetWidth];
+    float tMin[packetWidth], tMax[packetWidth];
+    uint32_t active = 0;    // Bit i set = lane i carries a ray
+
+    RayPacket8() { clear(); }
+
+    void clear() {
+        for (int i = 0; i < packetWidth; ++i) {
+            ox[i] = oy[i] = oz[i] = 0.0f;
+            dx[i] = dy[i] = 0.0f;
+            dz[i] = 1.0f;
+            tMin[i] = 0.0f;
+            tMax[i] = 0.0f;
+        }
+        active = 0;
+    }
+
+    void setLane(int lane, const glm::vec3& origin, const glm::vec3& direction, float laneTMin, float laneTMax) {
+        ox[lane] = origin.x; oy[lane] = origin.y; oz[lane] = origin.z;
+        dx[lane] = direction.x; dy[lane] = direction.y; dz[lane] = direction.z;
+        tMin[lane] = laneTMin;
+        tMax[lane] = laneTMax;
+        active |= 1u << lane;
+    }
+};
+
+struct alignas(32) PacketHit8 {
+    float t[packetWidth];
+    int32_t triangle[packetWidth];  // -1 = miss (or inactive lane)
+    int32_t instance[packetWidth];  // Filled in by RayTracer for two-level scenes (see Hit::instance)
+};
+
+// Triangles as separate coordinate arrays (vertex 0 and both edges), indexed
+// like Scene::triangles, so one triangle broadcasts across the packet lanes
+struct TriangleSoA {
+    std::vector<float> v0x, v0y, v0z;
+    std::vector<float> e1x, e1y, e1z;
+    std::vector<float> e2x, e2y, e2z;
+
+    void build(const std::vector<Triangle>& triangles);
+    size_t size() const { return v0x.size(); }
+};
+
+// Closest hit for every active lane
+void intersectPacket(const Bvh& bvh, const TriangleSoA& triangles, const RayPacket8& packet, PacketHit8& hit);
+
+// Returns the lanes (bit mask) whose ray hits anything before its tMax
+uint32_t occludedPacket(const Bvh& bvh, const TriangleSoA& triangles, const RayPacket8& packet);
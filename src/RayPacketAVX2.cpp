@@ -0,0 +1,69 @@
+// RayPacketAVX2.cpp
+// ---------------------------------------------------------
+// AVX2 packet kernels: one __m256 holds all 8 lanes. Compiled
+// with AVX2 enabled (see CMakeLists.txt) and only called when
+// the CPU reports AVX2 support.
+// ---------------------------------------------------------
+
+#include "RayPacketKernels.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__AVX2__)
+namespace {
+
+struct Avx8 {
+    __m256 v;
+
+    static Avx8 make(__m256 v) { Avx8 r; r.v = v; return r; }
+    static Avx8 set1(float f) { return make(_mm256_set1_ps(f)); }
+    static Avx8 load(const float* p) { return make(_mm256_load_ps(p)); }
+    void store(float* p) const { _mm256_store_ps(p, v); }
+
+    friend Avx8 operator+(const Avx8& a, const Avx8& b) { return make(_mm256_add_ps(a.v, b.v)); }
+    friend Avx8 operator-(const Avx8& a, const Avx8& b) { return make(_mm256_sub_ps(a.v, b.v)); }
+    friend Avx8 operator*(const Avx8& a, const Avx8& b) { return make(_mm256_mul_ps(a.v, b.v)); }
+    friend Avx8 operator/(const Avx8& a, const Avx8& b) { return make(_mm256_div_ps(a.v, b.v)); }
+
+    static Avx8 min(const Avx8& a, const Avx8& b) { return make(_mm256_min_ps(a.v, b.v)); }
+    static Avx8 max(const Avx8& a, const Avx8& b) { return make(_mm256_max_ps(a.v, b.v)); }
+    static Avx8 abs(const Avx8& a) { return make(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)); }
+
+    static Avx8 lt(const Avx8& a, const Avx8& b) { return make(_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)); }
+    static Avx8 le(const Avx8& a, const Avx8& b) { return make(_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)); }
+
+    static Avx8 andMask(const Avx8& a, const Avx8& b) { return make(_mm256_and_ps(a.v, b.v)); }
+    static Avx8 andNot(const Avx8& a, const Avx8& b) { return make(_mm256_andnot_ps(b.v, a.v)); }
+    static Avx8 blend(const Avx8& a, const Avx8& b, const Avx8& mask) { return make(_mm256_blendv_ps(a.v, b.v, mask.v)); }
+
+    // Lane i all-ones when bit i of `bits` is set
+    static Avx8 laneMask(uint32_t bits) {
+        const __m256i bit = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        const __m256i b = _mm256_and_si256(_mm256_set1_epi32(static_cast<int>(bits)), bit);
+        return make(_mm256_castsi256_ps(_mm256_cmpeq_epi32(b, bit)));
+    }
+
+    int movemask() const { return _mm256_movemask_ps(v); }
+};
+
+} // namespace
+
+void intersectPacketAVX2(const Bvh& bvh, const TriangleSoA& triangles, const RayPacket8& packet, PacketHit8& hit) {
+    intersectPacketKernel<Avx8>(bvh, triangles, packet, hit);
+}
+
+uint32_t occludedPacketAVX2(const Bvh& bvh, const TriangleSoA& triangles, const RayPacket8& packet) {
+    return occludedPacketKernel<Avx8>(bvh, triangles, packet);
+}
+#else
+// Built without AVX2 support (non-x86 target): never selected by the dispatcher
+void intersectPacketAVX2(const Bvh& bvh, const TriangleSoA& triangles, const RayPacket8& packet, PacketHit8& hit) {
+    intersectPacketScalar(bvh, triangles, packet, hit);
+}
+
+uint32_t occludedPacketAVX2(const Bvh& bvh, const TriangleSoA& triangles, const RayPacket8& packet) {
+    return occludedPacketScalar(bvh, triangles, packet);
+}
+#endif
@@ -0,0 +1,218 @@
+// RayPacketKernels.hpp
+// ---------------------------------------------------------
+// Packet traversal shared by the SIMD kernels (internal).
+// Written once against a small 8-lane float type `V`; each
+// kernel file supplies V for its instruction set:
+//   V::set1, V::load, store, + - * /, V::min, V::max,
+//   V::lt / V::le (lane masks), V::andMask, V::andNot,
+//   V::blend(a, b, mask) = mask ? b : a, V::abs,
+//   V::laneMask(bits), movemask()
+// ---------------------------------------------------------
+
+#pragma once
+
+#include "RayPacket.hpp"
+
+#include <cstring>
+
+// Entry points implemented in RayPacket.cpp (scalar, one lane at a time)
+// and RayPacketSSE.cpp / RayPacketAVX2.cpp
+void intersectPacketScalar(const Bvh& bvh, const TriangleSoA& triangles, const RayPacket8& packet, PacketHit8& hit);
+uint32_t occludedPacketScalar(const Bvh& bvh, const TriangleSoA& triangles, const RayPacket8& packet);
+void intersectPacketSSE(const Bvh& bvh, const TriangleSoA& triangles, const RayPacket8& packet, PacketHit8& hit);
+uint32_t occludedPacketSSE(const Bvh& bvh, const TriangleSoA& triangles, const RayPacket8& packet);
+void intersectPacketAVX2(const Bvh& bvh, const TriangleSoA& triangles, const RayPacket8& packet, PacketHit8& hit);
+uint32_t occludedPacketAVX2(const Bvh& bvh, const TriangleSoA& triangles, const RayPacket8& packet);
+
+template<typename V>
+struct PacketRays {
+    V ox, oy, oz;
+    V dx, dy, dz;
+    V ix, iy, iz;   // 1 / direction
+    V tMin;
+    float dirX, dirY, dirZ; // Direction of the first active lane (child ordering)
+
+    explicit PacketRays(const RayPacket8& p)
+        : ox(V::load(p.ox)), oy(V::load(p.oy)), oz(V::load(p.oz)),
+          dx(V::load(p.dx)), dy(V::load(p.dy)), dz(V::load(p.dz)),
+          ix(V::set1(1.0f) / dx), iy(V::set1(1.0f) / dy), iz(V::set1(1.0f) / dz),
+          tMin(V::load(p.tMin))
+    {
+        int lane = 0;
+        while (lane < packetWidth - 1 && !(p.active & (1u << lane)))
+            ++lane;
+        dirX = p.dx[lane];
+        dirY = p.dy[lane];
+        dirZ = p.dz[lane];
+    }
+};
+
+// Lanes of `active` whose ray enters the node's box before its tMax
+template<typename V>
+inline V packetHitsBox(const PacketRays<V>& r, const BvhNode& node, const V& tMax, const V& active) {
+    const V tx0 = (V::set1(node.boundsMin.x) - r.ox) * r.ix;
+    const V tx1 = (V::set1(node.boundsMax.x) - r.ox) * r.ix;
+    const V ty0 = (V::set1(node.boundsMin.y) - r.oy) * r.iy;
+    const V ty1 = (V::set1(node.boundsMax.y) - r.oy) * r.iy;
+    const V tz0 = (V::set1(node.boundsMin.z) - r.oz) * r.iz;
+    const V tz1 = (V::set1(node.boundsMax.z) - r.oz) * r.iz;
+    const V tEnter = V::max(V::max(V::min(tx0, tx1), V::min(ty0, ty1)), V::max(V::min(tz0, tz1), r.tMin));
+    const V tExit = V::min(V::min(V::max(tx0, tx1), V::max(ty0, ty1)), V::min(V::max(tz0, tz1), tMax));
+    return V::andMask(active, V::le(tEnter, tExit));
+}
+
+// Moller-Trumbore of every lane against triangle `i` (broadcast). Same
+// operations as the scalar intersectTriangle, so hits agree with it.
+template<typename V>
+inline V packetHitsTriangle(const PacketRays<V>& r, const TriangleSoA& tris, uint32_t i,
+                            const V& tMax, const V& active, V& tOut) {
+    const V e1x = V::set1(tris.e1x[i]), e1y = V::set1(tris.e1y[i]), e1z = V::set1(tris.e1z[i]);
+    const V e2x = V::set1(tris.e2x[i]), e2y = V::set1(tris.e2y[i]), e2z = V::set1(tris.e2z[i]);
+
+    // p = d x e2
+    const V px = r.dy * e2z - r.dz * e2y;
+    const V py = r.dz * e2x - r.dx * e2z;
+    const V pz = r.dx * e2y - r.dy * e2x;
+    const V det = e1x * px + e1y * py + e1z * pz;
+    const V invDet = V::set1(1.0f) / det;
+
+    const V sx = r.ox - V::set1(tris.v0x[i]);
+    const V sy = r.oy - V::set1(tris.v0y[i]);
+    const V sz = r.oz - V::set1(tris.v0z[i]);
+    const V u = (sx * px + sy * py + sz * pz) * invDet;
+
+    // q = s x e1
+    const V qx = sy * e1z - sz * e1y;
+    const V qy = sz * e1x - sx * e1z;
+    const V qz = sx * e1y - sy * e1x;
+    const V v = (r.dx * qx + r.dy * qy + r.dz * qz) * invDet;
+    const V t = (e2x * qx + e2y * qy + e2z * qz) * invDet;
+
+    const V zero = V::set1(0.0f);
+    const V one = V::set1(1.0f);
+    V mask = V::andMask(active, V::le(V::set1(1e-8f), V::abs(det)));
+    mask = V::andMask(mask, V::andMask(V::le(zero, u), V::le(u, one)));
+    mask = V::andMask(mask, V::andMask(V::le(zero, v), V::le(u + v, one)));
+    mask = V::andMask(mask, V::andMask(V::lt(r.tMin, t), V::lt(t, tMax)));
+    tOut = t;
+    return mask;
+}
+
+// Near child first: the child whose center lies on the side the packet travels towards
+inline bool leftChildFirst(const BvhNode* nodes, const BvhNode& node, uint32_t self, float dirX, float dirY, float dirZ) {
+    const BvhNode& left = nodes[self + 1];
+    const BvhNode& right = nodes[node.index];
+    const glm::vec3 delta = (right.boundsMin + right.boundsMax) - (left.boundsMin + left.boundsMax);
+    const glm::vec3 a = glm::abs(delta);
+    const float dir = (a.x >= a.y && a.x >= a.z) ? dirX : (a.y >= a.z ? dirY : dirZ);
+    const float d = (a.x >= a.y && a.x >= a.z) ? delta.x : (a.y >= a.z ? delta.y : delta.z);
+    return (d >= 0.0f) == (dir >= 0.0f);
+}
+
+template<typename V>
+inline void intersectPacketKernel(const Bvh& bvh, const TriangleSoA& tris, const RayPacket8& packet, PacketHit8& hit) {
+    for (int i = 0; i < packetWidth; ++i) {
+        hit.t[i] = std::numeric_limits<float>::infinity();
+        hit.triangle[i] = -1;
+    }
+    if (bvh.nodes.empty() || packet.active == 0)
+        return;
+
+    const PacketRays<V> r(packet);
+    const V active = V::laneMask(packet.active);
+    V tMax = V::load(packet.tMax);
+    V triangle = V::load(reinterpret_cast<const float*>(hit.triangle));
+    bool anyHit = false;
+
+    const BvhNode* nodes = bvh.nodes.data();
+    uint32_t stack[128];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        const uint32_t index = stack[--stackSize];
+        const BvhNode& node = nodes[index];
+        const V mask = packetHitsBox(r, node, tMax, active);
+        if (mask.movemask() == 0)
+            continue;
+
+        if (node.isLeaf()) {
+            for (uint32_t k = 0; k < node.count; ++k) {
+                const uint32_t tri = bvh.primitives[node.index + k];
+                V t;
+                const V triMask = packetHitsTriangle(r, tris, tri, tMax, mask, t);
+                if (triMask.movemask() != 0) {
+                    tMax = V::blend(tMax, t, triMask);
+                    int32_t id = static_cast<int32_t>(tri);
+                    float idBits;
+                    std::memcpy(&idBits, &id, sizeof(idBits));
+                    triangle = V::blend(triangle, V::set1(idBits), triMask);
+                    anyHit = true;
+                }
+            }
+        }
+        else if (leftChildFirst(nodes, node, index, r.dirX, r.dirY, r.dirZ)) {
+            stack[stackSize++] = node.index;
+            stack[stackSize++] = index + 1;
+        }
+        else {
+            stack[stackSize++] = index + 1;
+            stack[stackSize++] = node.index;
+        }
+    }
+
+    if (!anyHit)
+        return;
+    triangle.store(reinterpret_cast<float*>(hit.triangle));
+    alignas(32) float t[packetWidth];
+    tMax.store(t);
+    for (int i = 0; i < packetWidth; ++i) {
+        if (hit.triangle[i] >= 0)
+            hit.t[i] = t[i];
+    }
+}
+
+template<typename V>
+inline uint32_t occludedPacketKernel(const Bvh& bvh, const TriangleSoA& tris, const RayPacket8& packet) {
+    if (bvh.nodes.empty() || packet.active == 0)
+        return 0;
+
+    const PacketRays<V> r(packet);
+    V active = V::laneMask(packet.active);
+    const V tMax = V::load(packet.tMax);
+    uint32_t blocked = 0;
+
+    const BvhNode* nodes = bvh.nodes.data();
+    uint32_t stack[128];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        const uint32_t index = stack[--stackSize];
+        const BvhNode& node = nodes[index];
+        V mask = packetHitsBox(r, node, tMax, active);
+        if (mask.movemask() == 0)
+            continue;
+
+        if (node.isLeaf()) {
+            for (uint32_t k = 0; k < node.count; ++k) {
+                V t;
+                const V triMask = packetHitsTriangle(r, tris, bvh.primitives[node.index + k], tMax, mask, t);
+                const int bits = triMask.movemask();
+                if (bits != 0) {
+                    // Blocked lanes are done: drop them from the rest of the walk
+                    blocked |= static_cast<uint32_t>(bits);
+                    if (blocked == packet.active)
+                        return blocked;
+                    active = V::andNot(active, triMask);
+                    mask = V::andNot(mask, triMask);
+                }
+            }
+        }
+        else {
+            stack[stackSize++] = node.index;
+            stack[stackSize++] = index + 1;
+        }
+    }
+    return blocked;
+}
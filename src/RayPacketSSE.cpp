@@ -0,0 +1,77 @@
+// RayPacketSSE.cpp
+// ---------------------------------------------------------
+// SSE2 packet kernels: each 8-lane value is two __m128 halves.
+// SSE2 is part of every x86-64 CPU, so no extra compiler flags.
+// ---------------------------------------------------------
+
+#include "RayPacketKernels.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RAYPACKET_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(RAYPACKET_SSE2)
+namespace {
+
+struct Sse8 {
+    __m128 lo, hi;
+
+    static Sse8 make(__m128 lo, __m128 hi) { Sse8 r; r.lo = lo; r.hi = hi; return r; }
+    static Sse8 set1(float f) { const __m128 v = _mm_set1_ps(f); return make(v, v); }
+    static Sse8 load(const float* p) { return make(_mm_load_ps(p), _mm_load_ps(p + 4)); }
+    void store(float* p) const { _mm_store_ps(p, lo); _mm_store_ps(p + 4, hi); }
+
+    friend Sse8 operator+(const Sse8& a, const Sse8& b) { return make(_mm_add_ps(a.lo, b.lo), _mm_add_ps(a.hi, b.hi)); }
+    friend Sse8 operator-(const Sse8& a, const Sse8& b) { return make(_mm_sub_ps(a.lo, b.lo), _mm_sub_ps(a.hi, b.hi)); }
+    friend Sse8 operator*(const Sse8& a, const Sse8& b) { return make(_mm_mul_ps(a.lo, b.lo), _mm_mul_ps(a.hi, b.hi)); }
+    friend Sse8 operator/(const Sse8& a, const Sse8& b) { return make(_mm_div_ps(a.lo, b.lo), _mm_div_ps(a.hi, b.hi)); }
+
+    static Sse8 min(const Sse8& a, const Sse8& b) { return make(_mm_min_ps(a.lo, b.lo), _mm_min_ps(a.hi, b.hi)); }
+    static Sse8 max(const Sse8& a, const Sse8& b) { return make(_mm_max_ps(a.lo, b.lo), _mm_max_ps(a.hi, b.hi)); }
+    static Sse8 abs(const Sse8& a) {
+        const __m128 sign = _mm_set1_ps(-0.0f);
+        return make(_mm_andnot_ps(sign, a.lo), _mm_andnot_ps(sign, a.hi));
+    }
+
+    static Sse8 lt(const Sse8& a, const Sse8& b) { return make(_mm_cmplt_ps(a.lo, b.lo), _mm_cmplt_ps(a.hi, b.hi)); }
+    static Sse8 le(const Sse8& a, const Sse8& b) { return make(_mm_cmple_ps(a.lo, b.lo), _mm_cmple_ps(a.hi, b.hi)); }
+
+    static Sse8 andMask(const Sse8& a, const Sse8& b) { return make(_mm_and_ps(a.lo, b.lo), _mm_and_ps(a.hi, b.hi)); }
+    static Sse8 andNot(const Sse8& a, const Sse8& b) { return make(_mm_andnot_ps(b.lo, a.lo), _mm_andnot_ps(b.hi, a.hi)); }
+    static Sse8 blend(const Sse8& a, const Sse8& b, const Sse8& mask) {
+        return make(_mm_or_ps(_mm_andnot_ps(mask.lo, a.lo), _mm_and_ps(mask.lo, b.lo)),
+                    _mm_or_ps(_mm_andnot_ps(mask.hi, a.hi), _mm_and_ps(mask.hi, b.hi)));
+    }
+
+    // Lane i all-ones when bit i of `bits` is set
+    static Sse8 laneMask(uint32_t bits) {
+        const __m128i b = _mm_set1_epi32(static_cast<int>(bits));
+        const __m128i lo = _mm_setr_epi32(1, 2, 4, 8);
+        const __m128i hi = _mm_setr_epi32(16, 32, 64, 128);
+        return make(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(b, lo), lo)),
+                    _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(b, hi), hi)));
+    }
+
+    int movemask() const { return _mm_movemask_ps(lo) | (_mm_movemask_ps(hi) << 4); }
+};
+
+} // namespace
+
+void intersectPacketSSE(const Bvh& bvh, const TriangleSoA& triangles, const RayPacket8& packet, PacketHit8& hit) {
+    intersectPacketKernel<Sse8>(bvh, triangles, packet, hit);
+}
+
+uint32_t occludedPacketSSE(const Bvh& bvh, const TriangleSoA& triangles, const RayPacket8& packet) {
+    return occludedPacketKernel<Sse8>(bvh, triangles, packet);
+}
+#else
+// Built without SSE2 (non-x86 target): never selected by the dispatcher
+void intersectPacketSSE(const Bvh& bvh, const TriangleSoA& triangles, const RayPacket8& packet, PacketHit8& hit) {
+    intersectPacketScalar(bvh, triangles, packet, hit);
+}
+
+uint32_t occludedPacketSSE(const Bvh& bvh, const TriangleSoA& triangles, const RayPacket8& packet) {
+    return occludedPacketScalar(bvh, triangles, packet);
+}
+#endif
@@ -0,0 +1,787 @@
+// RayTracer.cpp
+// ---------------------------------------------------------
+// CPU ray tracer implementation (see RayTracer.hpp)
+// ---------------------------------------------------------
+
+#include "RayTracer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+
+#include "ThreadPool.hpp"
+#include "stb_image_write.h"
+
+namespace {
+
+// Small integer hash (PCG output permutation) for per-pixel sample jitter.
+// Jitter depends only on (seed, pixel, sample), never on which thread runs the tile.
+uint32_t hashSample(uint32_t seed, uint32_t x, uint32_t y, uint32_t sample) {
+    uint32_t h = seed ^ (x * 0x9E3779B1u) ^ (y * 0x85EBCA77u) ^ (sample * 0xC2B2AE3Du);
+    h = h * 747796405u + 2891336453u;
+    h = ((h >> ((h >> 28u) + 4u)) ^ h) * 277803737u;
+    return (h >> 22u) ^ h;
+}
+
+float toUnitFloat(uint32_t bits) {
+    return static_cast<float>(bits >> 8) * (1.0f / 16777216.0f);
+}
+
+// Moller-Trumbore, two-sided. Returns t, or +inf on a miss.
+float intersectTriangle(const Ray& ray, const Triangle& tri) {
+    constexpr float epsilon = 1e-8f;
+    const glm::vec3 edge1 = tri.v1 - tri.v0;
+    const glm::vec3 edge2 = tri.v2 - tri.v0;
+    const glm::vec3 p = glm::cross(ray.direction, edge2);
+    const float det = glm::dot(edge1, p);
+    if (std::fabs(det) < epsilon)
+        return std::numeric_limits<float>::infinity();
+
+    const float invDet = 1.0f / det;
+    const glm::vec3 s = ray.origin - tri.v0;
+    const float u = glm::dot(s, p) * invDet;
+    if (u < 0.0f || u > 1.0f)
+        return std::numeric_limits<float>::infinity();
+
+    const glm::vec3 q = glm::cross(s, edge1);
+    const float v = glm::dot(ray.direction, q) * invDet;
+    if (v < 0.0f || u + v > 1.0f)
+        return std::numeric_limits<float>::infinity();
+
+    const float t = glm::dot(edge2, q) * invDet;
+    return (t > ray.tMin && t < ray.tMax) ? t : std::numeric_limits<float>::infinity();
+}
+
+} // namespace
+
+// -----------------------------
+// CameraRays
+// -----------------------------
+CameraRays::CameraRays(const Camera& camera, int width, int height)
+    : origin(camera.position),
+      invWidth(1.0f / static_cast<float>(width)),
+      invHeight(1.0f / static_cast<float>(height))
+{
+    const float aspect = static_cast<float>(width) / static_cast<float>(height);
+    inverseViewProjection = glm::inverse(camera.getProjectionMatrix(aspect) * camera.getViewMatrix());
+
+    // Far-plane points are affine in the pixel position, so the per-pixel
+    // direction change is constant once directions have unit depth
+    auto farPoint = [&](float ndcX, float ndcY) {
+        const glm::vec4 p = inverseViewProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+        return glm::vec3(p) / p.w;
+    };
+    const glm::vec3 center = farPoint(0.0f, 0.0f);
+    const float depth = glm::length(center - origin);
+    forward = (center - origin) / depth;
+    pixelStepX = (farPoint(2.0f * invWidth, 0.0f) - center) / depth;
+    pixelStepY = (farPoint(0.0f, -2.0f * invHeight) - center) / depth;
+}
+
+Ray CameraRays::generate(float px, float py) const {
+    // Pixel -> NDC (y flipped: image row 0 is the top of the screen)
+    const float ndcX = px * invWidth * 2.0f - 1.0f;
+    const float ndcY = 1.0f - py * invHeight * 2.0f;
+
+    // Any point on the pixel's line of sight; the far plane keeps precision
+    glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+    farPoint /= farPoint.w;
+
+    Ray ray;
+    ray.origin = origin;
+    ray.direction = glm::normalize(glm::vec3(farPoint) - origin);
+    return ray;
+}
+
+void CameraRays::pixelFootprint(const Ray& ray, const glm::vec3& point, const glm::vec3& normal,
+                                glm::vec3& dPdx, glm::vec3& dPdy) const {
+    const glm::vec3 direction = ray.direction * (1.0f / glm::dot(ray.direction, forward));
+    const glm::vec3 offset = point - ray.origin;
+    const float planeDistance = glm::dot(offset, normal);
+    auto transfer = [&](const glm::vec3& step) {
+        const glm::vec3 neighbour = direction + step;
+        const float t = planeDistance / glm::dot(neighbour, normal);
+        // The neighbouring ray runs parallel to the plane or away from it: unbounded footprint
+        if (!(t > 0.0f && t < std::numeric_limits<float>::max()))
+            return glm::vec3(std::numeric_limits<float>::infinity());
+        return neighbour * t - offset;
+    };
+    dPdx = transfer(pixelStepX);
+    dPdy = transfer(pixelStepY);
+}
+
+// -----------------------------
+// RayTracer
+// -----------------------------
+RayTracer::RayTracer(Scene scene, const BvhBuildSettings& bvhSettings) : sceneData(std::move(scene)) {
+    if (sceneData.materials.empty())
+        sceneData.materials.push_back(Material{});
+
+    // Patterns are baked once; a material naming a missing pattern stays plain
+    textures.reserve(sceneData.patterns.size());
+    for (const NoisePattern& pattern : sceneData.patterns)
+        textures.emplace_back(pattern);
+    for (Material& material : sceneData.materials) {
+        if (material.pattern >= static_cast<int>(textures.size()))
+            material.pattern = -1;
+    }
+
+    // Fog macro grids likewise
+    fogs.reserve(sceneData.fogVolumes.size());
+    for (const NoiseFog& fog : sceneData.fogVolumes)
+        fogs.emplace_back(fog);
+
+    meshBvhs.resize(1 + sceneData.meshes.size());
+    for (int mesh = -1; mesh < static_cast<int>(sceneData.meshes.size()); ++mesh) {
+        std::vector<Triangle>& triangles = mesh < 0 ? sceneData.triangles : sceneData.meshes[mesh].triangles;
+        MeshBvh& meshBvh = meshBvhs[mesh + 1];
+
+        std::vector<Bounds> bounds(triangles.size());
+        for (size_t i = 0; i < bounds.size(); ++i) {
+            const Triangle& tri = triangles[i];
+            bounds[i] = triangleBounds(tri.v0, tri.v1, tri.v2);
+            meshBvh.bounds.grow(bounds[i]);
+        }
+        meshBvh.stats = meshBvh.bvh.build(bounds, bvhSettings);
+
+        // Store triangles in leaf order so each leaf reads one contiguous run
+        std::vector<Triangle> ordered(triangles.size());
+        for (size_t i = 0; i < ordered.size(); ++i) {
+            ordered[i] = triangles[meshBvh.bvh.primitives[i]];
+            meshBvh.bvh.primitives[i] = static_cast<uint32_t>(i);
+        }
+        triangles = std::move(ordered);
+        meshBvh.soa.build(triangles);
+    }
+
+    // Top level: the static triangles (if any) are one more, untransformed entry
+    if (!sceneData.triangles.empty())
+        instanceBvhs.push_back(makeInstance(-1, -1, glm::mat4(1.0f)));
+    for (size_t i = 0; i < sceneData.instances.size(); ++i)
+        instanceBvhs.push_back(makeInstance(sceneData.instances[i].mesh, static_cast<int>(i), sceneData.instances[i].transform));
+    if (!sceneData.instances.empty())
+        updateInstances(true);
+}
+
+size_t RayTracer::triangleCount() const {
+    size_t count = sceneData.triangles.size();
+    for (const Instance& instance : sceneData.instances)
+        count += sceneData.meshes[instance.mesh].triangles.size();
+    return count;
+}
+
+// -----------------------------
+// Instances
+// -----------------------------
+InstanceBvh RayTracer::makeInstance(int mesh, int instance, const glm::mat4& transform) const {
+    InstanceBvh entry;
+    entry.mesh = mesh;
+    entry.instance = instance;
+    entry.identity = transform == glm::mat4(1.0f);
+    entry.toObject = glm::inverse(transform);
+    entry.normalToWorld = glm::transpose(glm::inverse(glm::mat3(transform)));
+
+    // World box around the transformed corners of the mesh box
+    const Bounds& box = meshBvhs[mesh + 1].bounds;
+    for (int corner = 0; corner < 8; ++corner) {
+        const glm::vec3 p((corner & 1) ? box.max.x : box.min.x,
+                          (corner & 2) ? box.max.y : box.min.y,
+                          (corner & 4) ? box.max.z : box.min.z);
+        entry.worldBounds.grow(glm::vec3(transform * glm::vec4(p, 1.0f)));
+    }
+    return entry;
+}
+
+void RayTracer::setInstanceTransform(int instance, const glm::mat4& transform) {
+    Instance& target = sceneData.instances[instance];
+    target.transform = transform;
+    const size_t staticEntries = instanceBvhs.size() - sceneData.instances.size();
+    instanceBvhs[staticEntries + instance] = makeInstance(target.mesh, instance, transform);
+}
+
+int RayTracer::addInstance(int mesh, const glm::mat4& transform) {
+    const int instance = sceneData.addInstance(mesh, transform);
+    instanceBvhs.push_back(makeInstance(mesh, instance, transform));
+    topLevelShapeChanged = true;
+    return instance;
+}
+
+void RayTracer::removeInstance(int instance) {
+    const size_t staticEntries = instanceBvhs.size() - sceneData.instances.size();
+    sceneData.instances.erase(sceneData.instances.begin() + instance);
+    instanceBvhs.erase(instanceBvhs.begin() + static_cast<std::ptrdiff_t>(staticEntries + instance));
+    for (size_t i = staticEntries + instance; i < instanceBvhs.size(); ++i)
+        --instanceBvhs[i].instance;
+    topLevelShapeChanged = true;
+}
+
+InstanceUpdateStats RayTracer::updateInstances(bool rebuild) {
+    const auto start = std::chrono::steady_clock::now();
+    InstanceUpdateStats stats;
+    stats.instances = sceneData.instances.size();
+
+    std::vector<Bounds> bounds(instanceBvhs.size());
+    for (size_t i = 0; i < bounds.size(); ++i)
+        bounds[i] = instanceBvhs[i].worldBounds;
+
+    if (rebuild || topLevelShapeChanged || topLevel.primitives.size() != bounds.size()) {
+        // One instance per leaf: an instance costs a whole mesh traversal
+        BvhBuildSettings settings;
+        settings.maxLeafSize = 1;
+        settings.parallelThreshold = std::numeric_limits<int>::max();
+        topLevel.build(bounds, settings);
+        topLevelShapeChanged = false;
+        stats.rebuilt = true;
+    }
+    else {
+        topLevel.refit(bounds);
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+const Triangle& RayTracer::hitTriangle(const Hit& hit) const {
+    const int mesh = hit.instance < 0 ? -1 : sceneData.instances[hit.instance].mesh;
+    return meshTriangles(mesh)[hit.triangle];
+}
+
+glm::vec3 RayTracer::hitNormal(const Hit& hit) const {
+    const Triangle& tri = hitTriangle(hit);
+    if (hit.instance < 0)
+        return tri.normal;
+    const size_t staticEntries = instanceBvhs.size() - sceneData.instances.size();
+    return glm::normalize(instanceBvhs[staticEntries + hit.instance].normalToWorld * tri.normal);
+}
+
+// -----------------------------
+// Ray queries
+// -----------------------------
+namespace {
+
+Ray toObjectSpace(const Ray& ray, const InstanceBvh& instance) {
+    if (instance.identity)
+        return ray;
+    // Direction stays unnormalized, so t means the same distance in both spaces
+    Ray local = ray;
+    local.origin = glm::vec3(instance.toObject * glm::vec4(ray.origin, 1.0f));
+    local.direction = glm::mat3(instance.toObject) * ray.direction;
+    return local;
+}
+
+// `lanes` of the packet, moved into the instance's object space
+RayPacket8 toObjectSpace(const RayPacket8& packet, uint32_t lanes, const InstanceBvh& instance) {
+    RayPacket8 local = packet;
+    local.active = lanes;
+    if (instance.identity)
+        return local;
+    const glm::mat3 linear(instance.toObject);
+    for (int lane = 0; lane < packetWidth; ++lane) {
+        if (!(lanes & (1u << lane)))
+            continue;
+        const glm::vec3 o = glm::vec3(instance.toObject * glm::vec4(packet.ox[lane], packet.oy[lane], packet.oz[lane], 1.0f));
+        const glm::vec3 d = linear * glm::vec3(packet.dx[lane], packet.dy[lane], packet.dz[lane]);
+        local.ox[lane] = o.x; local.oy[lane] = o.y; local.oz[lane] = o.z;
+        local.dx[lane] = d.x; local.dy[lane] = d.y; local.dz[lane] = d.z;
+    }
+    return local;
+}
+
+// Lanes of `lanes` that enter the node's box (the instance level is small:
+// plain per-lane slab tests)
+uint32_t lanesHittingNode(const RayPacket8& packet, const BvhRay* rays, uint32_t lanes, const BvhNode& node) {
+    uint32_t mask = 0;
+    for (int lane = 0; lane < packetWidth; ++lane) {
+        if ((lanes & (1u << lane)) &&
+            rays[lane].slab(node.boundsMin, node.boundsMax, packet.tMin[lane], packet.tMax[lane]) != std::numeric_limits<float>::infinity())
+            mask |= 1u << lane;
+    }
+    return mask;
+}
+
+void packetRays(const RayPacket8& packet, BvhRay* rays) {
+    for (int lane = 0; lane < packetWidth; ++lane)
+        rays[lane] = BvhRay(glm::vec3(packet.ox[lane], packet.oy[lane], packet.oz[lane]),
+                            glm::vec3(packet.dx[lane], packet.dy[lane], packet.dz[lane]));
+}
+
+} // namespace
+
+Hit RayTracer::intersectMesh(int mesh, const Ray& ray) const {
+    const std::vector<Triangle>& triangles = meshTriangles(mesh);
+    Hit hit;
+    Ray r = ray;
+    hit.t = meshBvhs[mesh + 1].bvh.traverse(ray.origin, ray.direction, ray.tMin, ray.tMax, [&](uint32_t i, float closest) {
+        r.tMax = closest;
+        const float t = intersectTriangle(r, triangles[i]);
+        if (t < closest)
+            hit.triangle = static_cast<int>(i);
+        return t;
+    });
+    return hit;
+}
+
+bool RayTracer::occludedMesh(int mesh, const Ray& ray) const {
+    const std::vector<Triangle>& triangles = meshTriangles(mesh);
+    return meshBvhs[mesh + 1].bvh.traverseAny(ray.origin, ray.direction, ray.tMin, ray.tMax, [&](uint32_t i) {
+        return intersectTriangle(ray, triangles[i]) < ray.tMax;
+    });
+}
+
+Hit RayTracer::intersect(const Ray& ray) const {
+    if (sceneData.instances.empty())
+        return intersectMesh(-1, ray);
+
+    // Instance level first, then the mesh BVH in object space
+    Hit hit;
+    hit.t = topLevel.traverse(ray.origin, ray.direction, ray.tMin, ray.tMax, [&](uint32_t entry, float closest) {
+        const InstanceBvh& instance = instanceBvhs[entry];
+        Ray local = toObjectSpace(ray, instance);
+        local.tMax = closest;
+        const Hit meshHit = intersectMesh(instance.mesh, local);
+        if (meshHit.t < closest) {
+            hit.triangle = meshHit.triangle;
+            hit.instance = instance.instance;
+        }
+        return meshHit.t;
+    });
+    return hit;
+}
+
+bool RayTracer::occluded(const Ray& ray) const {
+    if (sceneData.instances.empty())
+        return occludedMesh(-1, ray);
+    return topLevel.traverseAny(ray.origin, ray.direction, ray.tMin, ray.tMax, [&](uint32_t entry) {
+        const InstanceBvh& instance = instanceBvhs[entry];
+        return occludedMesh(instance.mesh, toObjectSpace(ray, instance));
+    });
+}
+
+void RayTracer::intersect(const RayPacket8& packet, PacketHit8& hit) const {
+    if (sceneData.instances.empty()) {
+        intersectPacket(meshBvhs[0].bvh, meshBvhs[0].soa, packet, hit);
+        std::fill(std::begin(hit.instance), std::end(hit.instance), -1);
+        return;
+    }
+
+    for (int lane = 0; lane < packetWidth; ++lane) {
+        hit.t[lane] = std::numeric_limits<float>::infinity();
+        hit.triangle[lane] = -1;
+        hit.instance[lane] = -1;
+    }
+    if (topLevel.empty() || packet.active == 0)
+        return;
+
+    // tMax of each lane shrinks to its closest hit, so later instances only report closer ones
+    RayPacket8 closest = packet;
+    BvhRay rays[packetWidth];
+    packetRays(packet, rays);
+    uint32_t stack[128];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const uint32_t index = stack[--stackSize];
+        const BvhNode& node = topLevel.nodes[index];
+        const uint32_t lanes = lanesHittingNode(closest, rays, packet.active, node);
+        if (lanes == 0)
+            continue;
+        if (!node.isLeaf()) {
+            stack[stackSize++] = node.index;
+            stack[stackSize++] = index + 1;
+            continue;
+        }
+        for (uint32_t k = 0; k < node.count; ++k) {
+            const InstanceBvh& instance = instanceBvhs[topLevel.primitives[node.index + k]];
+            const MeshBvh& mesh = meshBvhs[instance.mesh + 1];
+            PacketHit8 meshHit;
+            intersectPacket(mesh.bvh, mesh.soa, toObjectSpace(closest, lanes, instance), meshHit);
+            for (int lane = 0; lane < packetWidth; ++lane) {
+                if (meshHit.triangle[lane] < 0)
+                    continue;
+                closest.tMax[lane] = meshHit.t[lane];
+                hit.t[lane] = meshHit.t[lane];
+                hit.triangle[lane] = meshHit.triangle[lane];
+                hit.instance[lane] = instance.instance;
+            }
+        }
+    }
+}
+
+uint32_t RayTracer::occluded(const RayPacket8& packet) const {
+    if (sceneData.instances.empty())
+        return occludedPacket(meshBvhs[0].bvh, meshBvhs[0].soa, packet);
+    if (topLevel.empty() || packet.active == 0)
+        return 0;
+
+    BvhRay rays[packetWidth];
+    packetRays(packet, rays);
+    uint32_t blocked = 0;
+    uint32_t stack[128];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const uint32_t index = stack[--stackSize];
+        const BvhNode& node = topLevel.nodes[index];
+        const uint32_t lanes = lanesHittingNode(packet, rays, packet.active & ~blocked, node);
+        if (lanes == 0)
+            continue;
+        if (!node.isLeaf()) {
+            stack[stackSize++] = node.index;
+            stack[stackSize++] = index + 1;
+            continue;
+        }
+        for (uint32_t k = 0; k < node.count; ++k) {
+            const InstanceBvh& instance = instanceBvhs[topLevel.primitives[node.index + k]];
+            const MeshBvh& mesh = meshBvhs[instance.mesh + 1];
+            blocked |= occludedPacket(mesh.bvh, mesh.soa, toObjectSpace(packet, lanes & ~blocked, instance));
+            if (blocked == packet.active)
+                return blocked;
+        }
+    }
+    return blocked;
+}
+
+bool RayTracer::shadowRay(const Ray& ray, const Hit& hit, Ray& shadow) const {
+    const glm::vec3 normal = hitNormal(hit);
+    const glm::vec3 fragPos = ray.origin + ray.direction * hit.t;
+    const glm::vec3 toLight = sceneData.light.position - fragPos;
+    const float lightDistance = glm::length(toLight);
+    const glm::vec3 lightDir = toLight / lightDistance;
+
+    // Neither diffuse nor specular light reaches the eye: nothing to occlude
+    // (the specular term is positive exactly when its pow() base is)
+    const float diff = glm::dot(normal, lightDir);
+    const float specBase = glm::dot(-ray.direction, glm::reflect(-lightDir, normal));
+    if (diff <= 0.0f && specBase <= 0.0f)
+        return false;
+
+    // Start just off the surface, on the side the camera sees
+    const glm::vec3 facing = glm::dot(normal, ray.direction) < 0.0f ? normal : -normal;
+    shadow.origin = fragPos + facing * 1e-4f;
+    shadow.direction = lightDir;
+    shadow.tMin = 1e-4f;
+    shadow.tMax = lightDistance;
+    return true;
+}
+
+glm::vec3 RayTracer::patternColor(const Material& material, const Ray& ray, const Hit& hit, const glm::vec3& point,
+                                  const glm::vec3& normal, const CameraRays* cameraRays) const {
+    // Instances project in object space, so the pattern stays on the mesh as it moves
+    const InstanceBvh* instance = nullptr;
+    if (hit.instance >= 0) {
+        const size_t staticEntries = instanceBvhs.size() - sceneData.instances.size();
+        instance = &instanceBvhs[staticEntries + hit.instance];
+        if (instance->identity)
+            instance = nullptr;
+    }
+    const glm::vec3 local = instance ? glm::vec3(instance->toObject * glm::vec4(point, 1.0f)) : point;
+    const glm::vec3 localNormal = instance ? hitTriangle(hit).normal : normal;
+
+    // Project along the dominant axis of the normal: (z, y), (x, z) or (x, y)
+    const glm::vec3 a = glm::abs(localNormal);
+    const int axis = (a.x >= a.y && a.x >= a.z) ? 0 : (a.y >= a.z ? 1 : 2);
+    const int u = axis == 0 ? 2 : 0;
+    const int v = axis == 1 ? 2 : 1;
+
+    // Isotropic footprint: the longer pixel edge on the projection plane
+    float footprint = 0.0f;
+    if (cameraRays) {
+        glm::vec3 dPdx, dPdy;
+        cameraRays->pixelFootprint(ray, point, normal, dPdx, dPdy);
+        if (instance) {
+            const glm::mat3 linear(instance->toObject);
+            dPdx = linear * dPdx;
+            dPdy = linear * dPdy;
+        }
+        footprint = std::max(glm::length(glm::vec2(dPdx[u], dPdx[v])), glm::length(glm::vec2(dPdy[u], dPdy[v])));
+    }
+
+    const NoiseTexture& texture = textures[material.pattern];
+    const glm::vec2 p(local[u], local[v]);
+    const float value = texturesEnabled ? texture.sample(p, footprint) : texture.evaluate(p);
+    return glm::mix(material.patternColor, material.color, value);
+}
+
+NoiseTextureStats RayTracer::noiseTextureStats() const {
+    NoiseTextureStats total;
+    for (const NoiseTexture& texture : textures) {
+        const NoiseTextureStats stats = texture.stats();
+        total.lookups += stats.lookups;
+        total.misses += stats.misses;
+        total.bytes += stats.bytes;
+        total.levels = std::max(total.levels, stats.levels);
+        total.resolution = std::max(total.resolution, stats.resolution);
+        total.bakeSeconds += stats.bakeSeconds;
+    }
+    return total;
+}
+
+void RayTracer::resetNoiseTextureStats() const {
+    for (const NoiseTexture& texture : textures)
+        texture.resetStats();
+}
+
+glm::vec3 RayTracer::applyFog(const Ray& ray, float tEnd, const glm::vec3& color) const {
+    if (fogs.size() == 1)
+        return fogs[0].march(ray.origin, ray.direction, tEnd, color, fogMarchMode);
+
+    // Back to front: each volume attenuates what the farther ones left
+    std::vector<std::pair<float, const FogVolume*>> crossed;
+    for (const FogVolume& fog : fogs) {
+        float t0, t1;
+        if (fog.clip(ray.origin, ray.direction, tEnd, t0, t1))
+            crossed.emplace_back(t0, &fog);
+    }
+    std::sort(crossed.begin(), crossed.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+    glm::vec3 result = color;
+    for (const auto& [t0, fog] : crossed)
+        result = fog->march(ray.origin, ray.direction, tEnd, result, fogMarchMode);
+    return result;
+}
+
+FogStats RayTracer::fogStats() const {
+    FogStats total;
+    for (const FogVolume& fog : fogs) {
+        const FogStats stats = fog.stats();
+        total.rays += stats.rays;
+        total.samples += stats.samples;
+        total.cells += stats.cells;
+        total.emptyCells += stats.emptyCells;
+        total.bytes += stats.bytes;
+        total.buildSeconds += stats.buildSeconds;
+    }
+    if (!fogs.empty()) {
+        const FogStats first = fogs[0].stats();
+        total.cellsX = first.cellsX;
+        total.cellsY = first.cellsY;
+        total.cellsZ = first.cellsZ;
+        total.emptyFraction = first.emptyFraction;
+    }
+    return total;
+}
+
+void RayTracer::resetFogStats() const {
+    for (const FogVolume& fog : fogs)
+        fog.resetStats();
+}
+
+glm::vec3 RayTracer::shadeHit(const Ray& ray, const Hit& hit, bool lit, const CameraRays* cameraRays) const {
+    const Material& material = sceneData.materials[hitTriangle(hit).material];
+    const PointLight& light = sceneData.light;
+    const glm::vec3 fragPos = ray.origin + ray.direction * hit.t;
+
+    // Same terms as cube.frag
+    const glm::vec3 norm = hitNormal(hit);
+    const glm::vec3 color = material.pattern >= 0 ? patternColor(material, ray, hit, fragPos, norm, cameraRays) : material.color;
+    const glm::vec3 lightDir = glm::normalize(light.position - fragPos);
+    const glm::vec3 ambient = material.ambientStrength * light.color;
+    if (!lit)
+        return ambient * color;
+
+    const float diff = std::max(glm::dot(norm, lightDir), 0.0f);
+    const glm::vec3 viewDir = -ray.direction;
+    const glm::vec3 reflectDir = glm::reflect(-lightDir, norm);
+    const float spec = std::pow(std::max(glm::dot(viewDir, reflectDir), 0.0f), material.shininess);
+
+    const glm::vec3 diffuse = diff * light.color;
+    const glm::vec3 specular = material.specularStrength * spec * light.color;
+    return (ambient + diffuse + specular) * color;
+}
+
+glm::vec3 RayTracer::shade(const Ray& ray, bool shadows, uint64_t& shadowRays, const CameraRays* cameraRays) const {
+    const Hit hit = intersect(ray);
+    if (!hit.valid())
+        return fogs.empty() ? sceneData.background : applyFog(ray, ray.tMax, sceneData.background);
+
+    bool lit = true;
+    Ray shadow;
+    if (shadows && shadowRay(ray, hit, shadow)) {
+        ++shadowRays;
+        lit = !occluded(shadow);
+    }
+    const glm::vec3 color = shadeHit(ray, hit, lit, cameraRays);
+    return fogs.empty() ? color : applyFog(ray, hit.t, color);
+}
+
+// 4x2 pixel blocks as packets: neighbouring rays walk the same BVH nodes,
+// so one SIMD box test serves all of them. The shadow rays of a block
+// (same light, nearby origins) go out as a second packet.
+uint32_t RayTracer::sampleBlock(const CameraRays& cameraRays, const RenderSettings& settings, const Noise::TileRect& tile,
+                                int x0, int y0, uint32_t firstSample, int samples, glm::vec3* colors,
+                                uint64_t& shadowRays) const {
+    const bool jitter = settings.samplesPerPixel > 1 || settings.firstSample > 0;
+
+    uint32_t active = 0;
+    for (int s = 0; s < samples; ++s, colors += packetWidth) {
+        const uint32_t sample = firstSample + static_cast<uint32_t>(s);
+        Ray rays[packetWidth];
+        RayPacket8 primary;
+        for (int lane = 0; lane < packetWidth; ++lane) {
+            const int x = x0 + lane % blockWidth, y = y0 + lane / blockWidth;
+            if (x >= tile.x1 || y >= tile.y1)
+                continue;
+            // A lone sample sits at the pixel center, like the rasterizer
+            float jx = 0.5f, jy = 0.5f;
+            if (jitter) {
+                jx = toUnitFloat(hashSample(settings.seed, x, y, sample));
+                jy = toUnitFloat(hashSample(settings.seed ^ 0x68E31DA4u, x, y, sample));
+            }
+            rays[lane] = cameraRays.generate(x + jx, y + jy);
+            primary.setLane(lane, rays[lane].origin, rays[lane].direction, rays[lane].tMin, rays[lane].tMax);
+        }
+        active = primary.active;
+
+        if (!settings.packets) {
+            for (int lane = 0; lane < packetWidth; ++lane) {
+                if (active & (1u << lane))
+                    colors[lane] = shade(rays[lane], settings.shadows, shadowRays, &cameraRays);
+            }
+            continue;
+        }
+
+        PacketHit8 packetHit;
+        intersect(primary, packetHit);
+
+        RayPacket8 shadow;
+        if (settings.shadows) {
+            for (int lane = 0; lane < packetWidth; ++lane) {
+                const Hit hit{ packetHit.t[lane], packetHit.triangle[lane], packetHit.instance[lane] };
+                Ray shadowLane;
+                if (hit.valid() && shadowRay(rays[lane], hit, shadowLane))
+                    shadow.setLane(lane, shadowLane.origin, shadowLane.direction, shadowLane.tMin, shadowLane.tMax);
+            }
+        }
+        const uint32_t blocked = shadow.active ? occluded(shadow) : 0u;
+        shadowRays += static_cast<uint64_t>(std::popcount(shadow.active));
+
+        for (int lane = 0; lane < packetWidth; ++lane) {
+            if (!(active & (1u << lane)))
+                continue;
+            const Hit hit{ packetHit.t[lane], packetHit.triangle[lane], packetHit.instance[lane] };
+            colors[lane] = hit.valid() ? shadeHit(rays[lane], hit, !(blocked & (1u << lane)), &cameraRays) : sceneData.background;
+            if (!fogs.empty())
+                colors[lane] = applyFog(rays[lane], hit.valid() ? hit.t : rays[lane].tMax, colors[lane]);
+        }
+    }
+    return active;
+}
+
+void RayTracer::renderTilePackets(const CameraRays& cameraRays, const RenderSettings& settings,
+                                  const Noise::TileRect& tile, Framebuffer& target, uint64_t& shadowRays) const {
+    const int spp = std::max(settings.samplesPerPixel, 1);
+    std::vector<glm::vec3> samples(static_cast<size_t>(spp) * packetWidth);
+
+    for (int by = tile.y0; by < tile.y1; by += blockHeight) {
+        for (int bx = tile.x0; bx < tile.x1; bx += blockWidth) {
+            const uint32_t active = sampleBlock(cameraRays, settings, tile, bx, by,
+                                                static_cast<uint32_t>(settings.firstSample), spp, samples.data(), shadowRays);
+            for (int lane = 0; lane < packetWidth; ++lane) {
+                if (!(active & (1u << lane)))
+                    continue;
+                glm::vec3 color(0.0f);
+                for (int s = 0; s < spp; ++s)
+                    color += samples[static_cast<size_t>(s) * packetWidth + lane];
+                target.at(bx + lane % blockWidth, by + lane / blockWidth) = color / static_cast<float>(spp);
+            }
+        }
+    }
+}
+
+RenderStats RayTracer::render(const Camera& camera, const RenderSettings& settings, Framebuffer& target) const {
+    const Noise::TileRect image{ 0, 0, std::max(settings.width, 1), std::max(settings.height, 1) };
+    return renderRegion(camera, settings, image, target);
+}
+
+RenderStats RayTracer::renderRegion(const Camera& camera, const RenderSettings& settings, const Noise::TileRect& region,
+                                    Framebuffer& target) const {
+    const int width = std::max(settings.width, 1);
+    const int height = std::max(settings.height, 1);
+    const int spp = std::max(settings.samplesPerPixel, 1);
+    const bool jitter = spp > 1 || settings.firstSample > 0;
+    if (target.width != width || target.height != height)
+        target.resize(width, height);   // Every pixel of the region is overwritten below
+
+    const int x0 = std::clamp(region.x0, 0, width), y0 = std::clamp(region.y0, 0, height);
+    const int x1 = std::clamp(region.x1, x0, width), y1 = std::clamp(region.y1, y0, height);
+    const CameraRays cameraRays(camera, width, height);
+    std::atomic<uint64_t> primaryRays{0};
+    std::atomic<uint64_t> shadowRays{0};
+
+    const auto start = std::chrono::steady_clock::now();
+
+    Noise::parallel_for_tiles(x1 - x0, y1 - y0, std::max(settings.tileSize, 1), [&](const Noise::TileRect& local) {
+        const Noise::TileRect tile{ local.x0 + x0, local.y0 + y0, local.x1 + x0, local.y1 + y0 };
+        uint64_t tileShadowRays = 0;
+        if (settings.packets) {
+            renderTilePackets(cameraRays, settings, tile, target, tileShadowRays);
+        }
+        else {
+            for (int y = tile.y0; y < tile.y1; ++y) {
+                for (int x = tile.x0; x < tile.x1; ++x) {
+                    glm::vec3 color(0.0f);
+                    for (int s = 0; s < spp; ++s) {
+                        // A lone sample sits at the pixel center, like the rasterizer
+                        const uint32_t sample = static_cast<uint32_t>(settings.firstSample + s);
+                        float jx = 0.5f, jy = 0.5f;
+                        if (jitter) {
+                            const uint32_t h = hashSample(settings.seed, x, y, sample);
+                            jx = toUnitFloat(h);
+                            jy = toUnitFloat(hashSample(settings.seed ^ 0x68E31DA4u, x, y, sample));
+                        }
+                        const Ray ray = cameraRays.generate(x + jx, y + jy);
+                        color += shade(ray, settings.shadows, tileShadowRays, &cameraRays);
+                    }
+                    target.at(x, y) = color / static_cast<float>(spp);
+                }
+            }
+        }
+        const uint64_t tilePixels = static_cast<uint64_t>(tile.x1 - tile.x0) * static_cast<uint64_t>(tile.y1 - tile.y0);
+        primaryRays.fetch_add(tilePixels * spp, std::memory_order_relaxed);
+        shadowRays.fetch_add(tileShadowRays, std::memory_order_relaxed);
+    });
+
+    RenderStats stats;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.primaryRays = primaryRays.load();
+    stats.shadowRays = shadowRays.load();
+    stats.threads = Noise::thread_count();
+    return stats;
+}
+
+// -----------------------------
+// Image output
+// -----------------------------
+bool writeFramebuffer(const Framebuffer& image, const std::string& path) {
+    if (image.width <= 0 || image.height <= 0)
+        return false;
+
+    std::vector<unsigned char> rgb(static_cast<size_t>(image.width) * image.height * 3);
+    for (size_t i = 0; i < image.pixels.size(); ++i) {
+        const glm::vec3 c = glm::clamp(image.pixels[i], 0.0f, 1.0f);
+        rgb[3 * i + 0] = static_cast<unsigned char>(c.r * 255.0f + 0.5f);
+        rgb[3 * i + 1] = static_cast<unsigned char>(c.g * 255.0f + 0.5f);
+        rgb[3 * i + 2] = static_cast<unsigned char>(c.b * 255.0f + 0.5f);
+    }
+
+    const std::filesystem::path file(path);
+    if (file.has_parent_path())
+        std::filesystem::create_directories(file.parent_path());
+
+    std::string extension = file.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    int result = 0;
+    if (extension == ".jpg" || extension == ".jpeg")
+        result = stbi_write_jpg(path.c_str(), image.width, image.height, 3, rgb.data(), 95);
+    else if (extension == ".bmp")
+        result = stbi_write_bmp(path.c_str(), image.width, image.height, 3, rgb.data());
+    else if (extension == ".tga")
+        result = stbi_write_tga(path.c_str(), image.width, image.height, 3, rgb.data());
+    else
+        result = stbi_write_png(path.c_str(), image.width, image.height, 3, rgb.data(), image.width * 3);
+    return result != 0;
+}
@@ -0,0 +1,270 @@
+// RayTracer.hpp
+// ---------------------------------------------------------
+// Multithreaded CPU ray tracer for the cube-on-platform scene
+// Features:
+//  - Primary rays from the same Camera (view, projection, zoom FOV)
+//  - Phong shading matching cube.frag, plus hard shadow rays
+//  - Screen tiles on RelNo_D1's work-stealing thread pool
+//  - SAH BVH over the scene triangles (Bvh.hpp)
+//  - Two levels for moving objects: one BVH per mesh, built once,
+//    and a small instance BVH refit or rebuilt in O(instances)
+//  - 8-wide SIMD ray packets for primary and shadow rays (RayPacket.hpp)
+//  - Noise pattern materials from baked, pre-filtered textures, the
+//    mip level picked from primary ray differentials (NoiseTexture.hpp)
+//  - Ray-marched noise fog over the shaded color, with empty-space
+//    skipping through a min / max density macro grid (FogVolume.hpp)
+//  - No OpenGL: runs headless (see rayTraceHeadless.cpp)
+// ---------------------------------------------------------
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "Bvh.hpp"
+#include "Camera.hpp"
+#include "FogVolume.hpp"
+#include "NoiseTexture.hpp"
+#include "RayPacket.hpp"
+#include "Scene.hpp"
+#include "ThreadPool.hpp"
+
+struct Ray {
+    glm::vec3 origin;
+    glm::vec3 direction;
+    float tMin = 1e-4f;
+    float tMax = std::numeric_limits<float>::infinity();
+};
+
+struct Hit {
+    float t = std::numeric_limits<float>::infinity();
+    int triangle = -1;
+    int instance = -1;  // Scene::instances entry (triangle indexes its mesh), -1 = static triangles
+
+    bool valid() const { return triangle >= 0; }
+};
+
+// Linear RGB image, row 0 at the top
+struct Framebuffer {
+    int width = 0;
+    int height = 0;
+    std::vector<glm::vec3> pixels;
+
+    Framebuffer() = default;
+    Framebuffer(int width, int height) { resize(width, height); }
+
+    void resize(int w, int h) {
+        width = w;
+        height = h;
+        pixels.assign(static_cast<size_t>(w) * static_cast<size_t>(h), glm::vec3(0.0f));
+    }
+
+    glm::vec3& at(int x, int y) { return pixels[static_cast<size_t>(y) * width + x]; }
+    const glm::vec3& at(int x, int y) const { return pixels[static_cast<size_t>(y) * width + x]; }
+};
+
+struct RenderSettings {
+    int width = 1280;
+    int height = 720;
+    int tileSize = 32;          // Edge of a screen tile (one thread-pool task)
+    int samplesPerPixel = 1;    // >1 jitters the samples inside each pixel
+    int firstSample = 0;        // Index of the first sample (progressive passes continue the jitter sequence)
+    bool shadows = true;        // Trace a shadow ray to the point light per hit
+    bool packets = true;        // Trace 4x2 pixel blocks as 8-wide ray packets (false = one ray at a time)
+    uint32_t seed = 0;          // Jitter pattern (results never depend on thread count)
+};
+
+struct RenderStats {
+    double seconds = 0.0;
+    uint64_t primaryRays = 0;
+    uint64_t shadowRays = 0;
+    unsigned threads = 1;
+
+    uint64_t rays() const { return primaryRays + shadowRays; }
+    double raysPerSecond() const { return seconds > 0.0 ? static_cast<double>(rays()) / seconds : 0.0; }
+    double raysPerSecondPerThread() const { return raysPerSecond() / static_cast<double>(threads); }
+};
+
+// Turns pixel coordinates into world-space rays by unprojecting through
+// inverse(projection * view), so the image lines up with the OpenGL view
+class CameraRays {
+public:
+    CameraRays(const Camera& camera, int width, int height);
+
+    // (px, py) in pixels, (0, 0) = top-left corner of the image
+    Ray generate(float px, float py) const;
+
+    // Ray differentials of a primary ray hitting `point` on a surface with
+    // `normal`: where the rays one pixel to the right (dPdx) and one pixel
+    // down (dPdy) meet the surface's plane, relative to `point`
+    void pixelFootprint(const Ray& ray, const glm::vec3& point, const glm::vec3& normal,
+                        glm::vec3& dPdx, glm::vec3& dPdy) const;
+
+private:
+    glm::mat4 inverseViewProjection;
+    glm::vec3 origin;
+    glm::vec3 forward;      // View axis
+    glm::vec3 pixelStepX;   // Direction change per pixel, for directions with unit depth along `forward`
+    glm::vec3 pixelStepY;
+    float invWidth;
+    float invHeight;
+};
+
+// Bottom level: the BVH of one triangle list (static triangles or one Mesh)
+struct MeshBvh {
+    Bvh bvh;
+    BvhStats stats;
+    TriangleSoA soa;
+    Bounds bounds;      // Object space
+};
+
+// Top level entry: a MeshBvh placed in the world
+struct InstanceBvh {
+    int mesh = -1;          // Scene::meshes index, -1 = static triangles
+    int instance = -1;      // Scene::instances index, -1 = static triangles
+    bool identity = true;   // Rays need no transform
+    glm::mat4 toObject = glm::mat4(1.0f);
+    glm::mat3 normalToWorld = glm::mat3(1.0f);
+    Bounds worldBounds;
+};
+
+struct InstanceUpdateStats {
+    double seconds = 0.0;
+    bool rebuilt = false;   // false = refit
+    size_t instances = 0;
+};
+
+class RayTracer {
+public:
+    // Builds one BVH per mesh (static triangles included); triangles are
+    // reordered to match its leaves. Instances go into the top-level BVH.
+    explicit RayTracer(Scene scene, const BvhBuildSettings& bvhSettings = {});
+
+    const Scene& scene() const { return sceneData; }
+
+    // BVH of the static triangles
+    const Bvh& bvh() const { return meshBvhs[0].bvh; }
+    const BvhStats& bvhStats() const { return meshBvhs[0].stats; }
+
+    // Triangles in the world: static plus every instance's mesh
+    size_t triangleCount() const;
+
+    // -----------------------------
+    // Instances: edits cost O(instances), never a mesh BVH rebuild.
+    // Call updateInstances() before rendering again.
+    // -----------------------------
+    void setInstanceTransform(int instance, const glm::mat4& transform);
+    int addInstance(int mesh, const glm::mat4& transform);
+    void removeInstance(int instance);     // Later instances move down by one
+
+    // Refits the instance BVH after transform changes, rebuilds it after adds
+    // or removes (or when `rebuild` is set)
+    InstanceUpdateStats updateInstances(bool rebuild = false);
+
+    // Triangle and world-space shading normal of a hit
+    const Triangle& hitTriangle(const Hit& hit) const;
+    glm::vec3 hitNormal(const Hit& hit) const;
+
+    // Renders the scene seen by `camera` into `target` (resized to settings.width x settings.height)
+    RenderStats render(const Camera& camera, const RenderSettings& settings, Framebuffer& target) const;
+
+    // Renders only the pixels of `region` (image coordinates, clamped to the image)
+    // of the settings.width x settings.height image; the rest of `target` is kept
+    RenderStats renderRegion(const Camera& camera, const RenderSettings& settings, const Noise::TileRect& region,
+                             Framebuffer& target) const;
+
+    // Closest hit along the ray
+    Hit intersect(const Ray& ray) const;
+
+    // True if anything blocks the ray before ray.tMax
+    bool occluded(const Ray& ray) const;
+
+    // Packet versions: closest hit per active lane / mask of blocked lanes
+    void intersect(const RayPacket8& packet, PacketHit8& hit) const;
+    uint32_t occluded(const RayPacket8& packet) const;
+
+    // Phong-shaded radiance seen along `ray` (background on a miss), through any
+    // fog volumes. `cameraRays` is the camera a primary ray came from: noise
+    // patterns then pick their mip level from its pixel footprint (null = finest level).
+    glm::vec3 shade(const Ray& ray, bool shadows, uint64_t& shadowRays, const CameraRays* cameraRays = nullptr) const;
+
+    // Ray from the hit point towards the light; false when the light cannot
+    // contribute there anyway (no shadow ray needed)
+    bool shadowRay(const Ray& ray, const Hit& hit, Ray& shadow) const;
+
+    // Phong terms at a hit; `lit` = false keeps only the ambient term
+    glm::vec3 shadeHit(const Ray& ray, const Hit& hit, bool lit, const CameraRays* cameraRays = nullptr) const;
+
+    // -----------------------------
+    // Noise patterns: one NoiseTexture per Scene::patterns entry, baked here
+    // -----------------------------
+    const std::vector<NoiseTexture>& noiseTextures() const { return textures; }
+
+    // false = evaluate the pattern fBm at every hit instead (reference / benchmark)
+    void setNoiseTexturesEnabled(bool enabled) { texturesEnabled = enabled; }
+    bool noiseTexturesEnabled() const { return texturesEnabled; }
+
+    // Lookups, misses and bytes over all patterns
+    NoiseTextureStats noiseTextureStats() const;
+    void resetNoiseTextureStats() const;
+
+    // -----------------------------
+    // Fog: one FogVolume per Scene::fogVolumes entry, macro grid built here
+    // -----------------------------
+    const std::vector<FogVolume>& fogVolumes() const { return fogs; }
+
+    // FixedStep = march every volume at NoiseFog::fixedStep (reference / benchmark)
+    void setFogMarch(FogMarch mode) { fogMarchMode = mode; }
+    FogMarch fogMarch() const { return fogMarchMode; }
+
+    // `color` (seen at ray.origin + tEnd * ray.direction) through every fog volume
+    // the ray crosses before tEnd; farther volumes are applied first
+    glm::vec3 applyFog(const Ray& ray, float tEnd, const glm::vec3& color) const;
+
+    // Rays, samples and cells summed over all volumes (grid figures of the first)
+    FogStats fogStats() const;
+    void resetFogStats() const;
+
+    // Pixel blocks traced together (one packet per block and sample)
+    static constexpr int blockWidth = 4;
+    static constexpr int blockHeight = 2;
+
+    // Samples firstSample .. firstSample + samples - 1 (jitter indices) for every
+    // pixel of the 4x2 block at (x0, y0) that lies inside `tile`. Lane i is pixel
+    // (x0 + i % 4, y0 + i / 4); colors[s * packetWidth + i] receives its sample s.
+    // Honors settings.packets / shadows / seed. Returns the lanes written.
+    uint32_t sampleBlock(const CameraRays& cameraRays, const RenderSettings& settings, const Noise::TileRect& tile,
+                         int x0, int y0, uint32_t firstSample, int samples, glm::vec3* colors,
+                         uint64_t& shadowRays) const;
+
+private:
+    void renderTilePackets(const CameraRays& cameraRays, const RenderSettings& settings, const Noise::TileRect& tile,
+                           Framebuffer& target, uint64_t& shadowRays) const;
+
+    const std::vector<Triangle>& meshTriangles(int mesh) const {
+        return mesh < 0 ? sceneData.triangles : sceneData.meshes[mesh].triangles;
+    }
+    Hit intersectMesh(int mesh, const Ray& ray) const;
+    bool occludedMesh(int mesh, const Ray& ray) const;
+    InstanceBvh makeInstance(int mesh, int instance, const glm::mat4& transform) const;
+    // Pattern at a hit, projected in the hit mesh's object space (patterns move with instances)
+    glm::vec3 patternColor(const Material& material, const Ray& ray, const Hit& hit, const glm::vec3& point,
+                           const glm::vec3& normal, const CameraRays* cameraRays) const;
+
+    Scene sceneData;
+    std::vector<MeshBvh> meshBvhs;      // [0] = static triangles, [1 + i] = sceneData.meshes[i]
+    std::vector<InstanceBvh> instanceBvhs;
+    Bvh topLevel;                       // Over instanceBvhs (empty when there are no instances)
+    bool topLevelShapeChanged = false;  // Instances added/removed since the last rebuild
+    std::vector<NoiseTexture> textures; // [i] = sceneData.patterns[i]
+    bool texturesEnabled = true;
+    std::vector<FogVolume> fogs;        // [i] = sceneData.fogVolumes[i]
+    FogMarch fogMarchMode = FogMarch::Adaptive;
+};
+
+// Writes the framebuffer as 8-bit RGB: .png (default), .jpg/.jpeg, .bmp or .tga.
+// Colors are clamped to [0,1] without gamma, like the OpenGL framebuffer.
+bool writeFramebuffer(const Framebuffer& image, const std::string& path);
@@ -0,0 +1,267 @@
+// Scene.hpp
+// ---------------------------------------------------------
+// The cube-on-platform scene, shared by the OpenGL view and
+// the CPU ray tracer so both draw exactly the same thing
+// ---------------------------------------------------------
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// -----------------------------
+// Geometry (position + normal, 6 floats per vertex)
+// -----------------------------
+inline constexpr float cubeVertices[] = {
+    // positions          // normals
+    // Back face
+    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+     0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+
+    // Front face
+    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+     0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+
+    // Left face
+    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
+    -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
+    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
+    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
+    -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
+    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
+
+    // Right face
+     0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
+     0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
+     0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
+     0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
+     0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
+     0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
+
+    // Bottom face
+    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
+     0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
+     0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
+     0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
+
+    // Top face
+    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f
+};
+
+// Platform vertices (a flat 10x10 plane at y = 0)
+inline constexpr float platformVertices[] = {
+    // positions          // normals
+    -5.0f, 0.0f, -5.0f,  0.0f,  1.0f,  0.0f,
+     5.0f, 0.0f, -5.0f,  0.0f,  1.0f,  0.0f,
+     5.0f, 0.0f,  5.0f,  0.0f,  1.0f,  0.0f,
+     5.0f, 0.0f,  5.0f,  0.0f,  1.0f,  0.0f,
+    -5.0f, 0.0f,  5.0f,  0.0f,  1.0f,  0.0f,
+    -5.0f, 0.0f, -5.0f,  0.0f,  1.0f,  0.0f
+};
+
+inline constexpr int cubeVertexCount = sizeof(cubeVertices) / (6 * sizeof(float));
+inline constexpr int platformVertexCount = sizeof(platformVertices) / (6 * sizeof(float));
+
+// -----------------------------
+// Scene defaults (what mainWindow starts with)
+// -----------------------------
+inline constexpr glm::vec3 defaultCubePosition(0.0f, 1.0f, 0.0f);
+inline constexpr glm::vec3 defaultLightPos(3.0f, 5.0f, 3.0f);
+inline constexpr glm::vec3 defaultLightColor(1.0f, 1.0f, 1.0f);
+inline constexpr glm::vec3 cubeColor(0.3f, 0.7f, 0.9f);      // Cyan-ish
+inline constexpr glm::vec3 platformColor(0.5f, 0.5f, 0.5f);  // Gray
+inline constexpr glm::vec3 backgroundColor(0.1f, 0.15f, 0.2f);
+
+// -----------------------------
+// Ray tracer scene description
+// -----------------------------
+
+// Phong material, same terms as cube.frag
+struct Material {
+    glm::vec3 color = glm::vec3(1.0f);
+    float ambientStrength = 0.3f;
+    float specularStrength = 0.5f;
+    float shininess = 32.0f;
+    int pattern = -1;                           // Scene::patterns index, -1 = plain color
+    glm::vec3 patternColor = glm::vec3(0.0f);   // Where the pattern is 0 (color where it is 1)
+};
+
+// Perlin fBm surface pattern, projected along the dominant axis of the
+// surface normal (a floor uses x/z). The ray tracer bakes it into a
+// NoiseTexture; outside the baked window it is evaluated per hit.
+struct NoisePattern {
+    glm::vec2 origin = glm::vec2(-5.0f);    // Corner of the baked window on the projection plane
+    float extent = 10.0f;                   // Edge of the baked window in world units
+    int resolution = 1024;                  // Texels per side of the finest level (rounded up to a power of two)
+    float featureSize = 2.0f;               // Lattice period of the first octave in world units
+    int octaves = 6;
+    float persistence = 0.5f;
+    float lacunarity = 2.0f;
+    int seed = 0;
+};
+
+// Ground fog: a participating medium in an axis-aligned box whose density is
+// 3D simplex fBm above a threshold: `coverage` at the bottom of the box, rising
+// to 1 at its top, so the fog thins out with height. The ray tracer builds a
+// FogVolume from it.
+struct NoiseFog {
+    glm::vec3 boundsMin = glm::vec3(-5.0f, 0.0f, -5.0f);
+    glm::vec3 boundsMax = glm::vec3(5.0f, 1.2f, 5.0f);
+    float density = 6.0f;                   // Extinction per world unit where the fog is thickest
+    float coverage = 0.5f;                  // fBm (in [0,1]) below this is clear air at the bottom
+    glm::vec3 color = glm::vec3(0.75f, 0.8f, 0.85f);   // Light the fog scatters towards the eye
+    float featureSize = 1.5f;               // Lattice period of the first octave in world units
+    int octaves = 4;
+    float persistence = 0.5f;
+    float lacunarity = 2.0f;
+    int seed = 0;
+    float cellSize = 0.25f;                 // Macro grid cell edge (min / max density per cell)
+    float fixedStep = 0.05f;                // Fixed-step marching step; the adaptive marcher's smallest step
+    float stepOpticalDepth = 0.25f;         // Adaptive marching: at most this much extinction per step
+};
+
+struct PointLight {
+    glm::vec3 position = defaultLightPos;
+    glm::vec3 color = defaultLightColor;
+};
+
+// World-space triangle with a flat shading normal
+struct Triangle {
+    glm::vec3 v0;
+    glm::vec3 v1;
+    glm::vec3 v2;
+    glm::vec3 normal;
+    int material = 0;
+};
+
+// Object-space triangles, placed in the world by one or more Instances
+struct Mesh {
+    std::vector<Triangle> triangles;
+};
+
+struct Instance {
+    int mesh = 0;
+    glm::mat4 transform = glm::mat4(1.0f);   // Object -> world
+};
+
+struct Scene {
+    std::vector<Triangle> triangles;    // Static world-space geometry
+    std::vector<Mesh> meshes;           // Instanced geometry (e.g. objects the gizmo moves)
+    std::vector<Instance> instances;
+    std::vector<Material> materials;
+    std::vector<NoisePattern> patterns;
+    std::vector<NoiseFog> fogVolumes;
+    PointLight light;
+    glm::vec3 background = backgroundColor;
+
+    int addMaterial(const Material& material) {
+        materials.push_back(material);
+        return static_cast<int>(materials.size()) - 1;
+    }
+
+    int addPattern(const NoisePattern& pattern) {
+        patterns.push_back(pattern);
+        return static_cast<int>(patterns.size()) - 1;
+    }
+
+    int addFog(const NoiseFog& fog) {
+        fogVolumes.push_back(fog);
+        return static_cast<int>(fogVolumes.size()) - 1;
+    }
+
+    // Append interleaved position + normal triangles (like cubeVertices), moved by `offset`
+    void addMesh(const float* vertices, int vertexCount, const glm::vec3& offset, int material) {
+        for (int i = 0; i + 2 < vertexCount; i += 3) {
+            const float* a = vertices + 6 * i;
+            Triangle tri;
+            tri.v0 = glm::vec3(a[0], a[1], a[2]) + offset;
+            tri.v1 = glm::vec3(a[6], a[7], a[8]) + offset;
+            tri.v2 = glm::vec3(a[12], a[13], a[14]) + offset;
+            tri.normal = glm::normalize(glm::vec3(a[3], a[4], a[5]));
+            tri.material = material;
+            triangles.push_back(tri);
+        }
+    }
+
+    // Interleaved position + normal triangles as a new instanced mesh; returns its index
+    int addInstancedMesh(const float* vertices, int vertexCount, int material) {
+        Scene mesh;
+        mesh.addMesh(vertices, vertexCount, glm::vec3(0.0f), material);
+        meshes.push_back(Mesh{ std::move(mesh.triangles) });
+        return static_cast<int>(meshes.size()) - 1;
+    }
+
+    int addInstance(int mesh, const glm::mat4& transform) {
+        instances.push_back(Instance{ mesh, transform });
+        return static_cast<int>(instances.size()) - 1;
+    }
+
+    // Append a columns x rows heightfield (row-major heights) as a size x size grid
+    // centered on the origin, two triangles per cell
+    void addHeightfield(const std::vector<float>& heights, int columns, int rows, float size, float heightScale, int material) {
+        if (columns < 2 || rows < 2)
+            return;
+        const float stepX = size / static_cast<float>(columns - 1);
+        const float stepZ = size / static_cast<float>(rows - 1);
+        auto vertex = [&](int x, int z) {
+            return glm::vec3(-0.5f * size + x * stepX, heights[static_cast<size_t>(z) * columns + x] * heightScale, -0.5f * size + z * stepZ);
+        };
+        triangles.reserve(triangles.size() + 2 * static_cast<size_t>(columns - 1) * static_cast<size_t>(rows - 1));
+        for (int z = 0; z + 1 < rows; ++z) {
+            for (int x = 0; x + 1 < columns; ++x) {
+                const glm::vec3 a = vertex(x, z), b = vertex(x + 1, z), c = vertex(x + 1, z + 1), d = vertex(x, z + 1);
+                for (const auto& t : { std::array<glm::vec3, 3>{ a, d, c }, std::array<glm::vec3, 3>{ a, c, b } }) {
+                    Triangle tri;
+                    tri.v0 = t[0];
+                    tri.v1 = t[1];
+                    tri.v2 = t[2];
+                    const glm::vec3 n = glm::cross(t[1] - t[0], t[2] - t[0]);
+                    tri.normal = glm::length(n) > 0.0f ? glm::normalize(n) : glm::vec3(0.0f, 1.0f, 0.0f);
+                    tri.material = material;
+                    triangles.push_back(tri);
+                }
+            }
+        }
+    }
+};
+
+// The scene mainWindow rasterizes: cube at cubePosition, the platform and one point light.
+// The cube is instance 0 (cubeInstance), so moving it only changes its transform.
+inline constexpr int cubeInstance = 0;
+
+inline Scene buildCubeScene(
+    const glm::vec3& cubePosition = defaultCubePosition,
+    const glm::vec3& lightPos = defaultLightPos,
+    const glm::vec3& lightColor = defaultLightColor
+) {
+    Scene scene;
+    Material cube;
+    cube.color = cubeColor;
+    Material platform;
+    platform.color = platformColor;
+
+    const int cubeMesh = scene.addInstancedMesh(cubeVertices, cubeVertexCount, scene.addMaterial(cube));
+    scene.addInstance(cubeMesh, glm::translate(glm::mat4(1.0f), cubePosition));
+    scene.addMesh(platformVertices, platformVertexCount, glm::vec3(0.0f), scene.addMaterial(platform));
+    scene.light.position = lightPos;
+    scene.light.color = lightColor;
+    return scene;
+}
@@ -0,0 +1,60 @@
+// ShardedCounter.hpp
+// ---------------------------------------------------------
+// Statistics counters bumped from every render thread
+// Features:
+//  - One cache line per shard; each thread adds to the shard its
+//    id maps to, so threads rarely write the same line
+//  - Relaxed fetch_add: exact even when threads share a shard
+//    (more threads than shards, or thread pools recreated)
+//  - total() sums the shards; reset() zeroes them
+// ---------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// `Count` counters, indexed 0 .. Count - 1. Adding is const: counting
+// lookups does not change the object being looked up.
+template <size_t Count>
+class ShardedCounter {
+public:
+    ShardedCounter() : shards(std::make_unique<Shard[]>(shardCount)) {}
+
+    void add(size_t counter, uint64_t value = 1) const {
+        shards[threadShard()].values[counter].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    uint64_t total(size_t counter) const {
+        uint64_t sum = 0;
+        for (int i = 0; shards && i < shardCount; ++i)
+            sum += shards[i].values[counter].load(std::memory_order_relaxed);
+        return sum;
+    }
+
+    void reset() const {
+        for (int i = 0; shards && i < shardCount; ++i) {
+            for (std::atomic<uint64_t>& value : shards[i].values)
+                value.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> values[Count] = {};
+    };
+    static constexpr int shardCount = 64;
+
+    // Threads are numbered on first use
+    static int threadShard() {
+        static std::atomic<int> nextThread{0};
+        thread_local int thread = -1;
+        if (thread < 0)
+            thread = nextThread.fetch_add(1, std::memory_order_relaxed);
+        return thread % shardCount;
+    }
+
+    std::unique_ptr<Shard[]> shards;
+};
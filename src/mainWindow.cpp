@@ -5,6 +5,9 @@
 #include <vector>
 #include <sstream>
 #include <iomanip>
+#include <cmath>
+#include <algorithm>
+#include <memory>
 
 // Include GLM for camera math
 #include <glm/glm.hpp>
@@ -23,8 +26,13 @@
 // Include Gizmo system
 #include "Gizmo.hpp"
 
+// Include shared scene data and the CPU ray tracer
+#include "Scene.hpp"
+#include "RayTracer.hpp"
+#include "ProgressiveRenderer.hpp"
+
 // Include RelNo_D1
-// #include "Noise.hpp"
+#include "Noise.hpp"
 
 // using namespace Noise;
 
@@ -41,9 +49,18 @@ bool gKeyPressed = false;
 
 // Gizmo and object selection
 GizmoState gizmoState;
-glm::vec3 cubePosition = glm::vec3(0.0f, 1.0f, 0.0f);  // Current cube position
+glm::vec3 cubePosition = defaultCubePosition;  // Current cube position
 bool cubeSelected = true;  // Cube is selected by default
 
+// CPU ray tracer snapshot (P key)
+bool pKeyPressed = false;
+bool rayTraceRequested = false;
+
+// Live progressive ray traced view (R key); sceneVersion changes when the cube moves
+bool rKeyPressed = false;
+bool rayTracedView = false;
+unsigned int sceneVersion = 0;
+
 // -----------------------------
 // Callbacks
 // -----------------------------
@@ -108,6 +125,27 @@ void processInput(GLFWwindow* window) {
         gKeyPressed = false;
     }
 
+    // Ray trace the current view to an image with P key
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS) {
+        if (!pKeyPressed) {
+            rayTraceRequested = true;
+            pKeyPressed = true;
+        }
+    } else {
+        pKeyPressed = false;
+    }
+
+    // Toggle the progressive ray traced view with R key
+    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS) {
+        if (!rKeyPressed) {
+            rayTracedView = !rayTracedView;
+            rKeyPressed = true;
+            std::cout << "Ray traced view: " << (rayTracedView ? "ON" : "OFF") << "\n";
+        }
+    } else {
+        rKeyPressed = false;
+    }
+
     // Handle gizmo dragging
     if (gizmoState.active && leftMousePressed) {
         double currentMouseX, currentMouseY;
@@ -133,6 +171,8 @@ void processInput(GLFWwindow* window) {
         
         // Apply movement
         cubePosition += axisVector * movement;
+        if (movement != 0.0f)
+            ++sceneVersion;
         
         // Update last mouse position
         lastMouseX = currentMouseX;
@@ -202,6 +242,8 @@ int main()
     std::cout << "  SHIFT      - Sprint (4x speed)\n";
     std::cout << "  Mouse Move - Look around\n";
     std::cout << "  G          - Toggle collision box visualization\n";
+    std::cout << "  P          - Ray trace current view to ImageOutput/raytrace_view.png\n";
+    std::cout << "  R          - Toggle live ray traced view (refines while nothing moves)\n";
     std::cout << "  ESC        - Exit\n";
     std::cout << "Collision detection: ENABLED\n";
     std::cout << "=======================\n\n";
@@ -214,71 +256,6 @@ int main()
     Shader lineShader("src/line.vert", "src/line.frag");
     std::cout << "Shaders loaded successfully!\n";
 
-    // -----------------------------
-    // Cube vertex data (position + normals)
-    // -----------------------------
-    float cubeVertices[] = {
-        // positions          // normals
-        // Back face
-        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
-         0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
-         0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
-         0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
-        -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
-        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
-
-        // Front face
-        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
-         0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
-         0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
-         0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
-        -0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
-        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
-
-        // Left face
-        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
-        -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
-        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
-        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
-        -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
-        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
-
-        // Right face
-         0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
-         0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
-         0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
-         0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
-         0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
-         0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
-
-        // Bottom face
-        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
-         0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
-         0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
-         0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
-        -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
-        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
-
-        // Top face
-        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,
-         0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,
-         0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
-         0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
-        -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
-        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f
-    };
-
-    // Platform vertices (a flat plane)
-    float platformVertices[] = {
-        // positions          // normals
-        -5.0f, 0.0f, -5.0f,  0.0f,  1.0f,  0.0f,
-         5.0f, 0.0f, -5.0f,  0.0f,  1.0f,  0.0f,
-         5.0f, 0.0f,  5.0f,  0.0f,  1.0f,  0.0f,
-         5.0f, 0.0f,  5.0f,  0.0f,  1.0f,  0.0f,
-        -5.0f, 0.0f,  5.0f,  0.0f,  1.0f,  0.0f,
-        -5.0f, 0.0f, -5.0f,  0.0f,  1.0f,  0.0f
-    };
-
     // -----------------------------
     // Setup Cube VAO and VBO
     // -----------------------------
@@ -477,9 +454,41 @@ int main()
     // std::cout << "Noise generated! Sample value = "
     //           << noiseMap[100][100] << "\n";
 
+    // -----------------------------
+    // Streaming terrain noise around the camera
+    // -----------------------------
+    // 256x256 Perlin tiles, one per 16x16 world units, generated on a
+    // background thread. The render loop only moves the focus and does
+    // non-blocking lookups, so a missing tile never stalls a frame.
+    Noise::NoiseTileProvider terrainTiles(
+        Noise::perlin_tile_generator(40.0f, 4, 1.0f, 0.5f, 2.0f, 0.0f, 21),
+        256,          // tile size (pixels)
+        2,            // prefetch radius (tiles)
+        64ull << 20,  // memory budget
+        1,            // worker threads
+        16.0f         // world units per tile
+    );
+    const float terrainPixelsPerUnit = 256.0f / 16.0f;
+
     // Light properties
-    glm::vec3 lightPos(3.0f, 5.0f, 3.0f);
-    glm::vec3 lightColor(1.0f, 1.0f, 1.0f);
+    glm::vec3 lightPos = defaultLightPos;
+    glm::vec3 lightColor = defaultLightColor;
+
+    // -----------------------------
+    // Live ray traced view (R key)
+    // -----------------------------
+    // Every frame adds samples to a float accumulation buffer within a small
+    // time budget; moving the camera or dragging the cube starts over. The
+    // running average goes into a float texture and is blitted to the screen.
+    std::unique_ptr<RayTracer> liveTracer;
+    unsigned int liveSceneVersion = 0;
+    ProgressiveRenderer progressive;
+    RenderStats liveStats;
+
+    unsigned int rayTexture = 0, rayFBO = 0;
+    int rayTextureWidth = 0, rayTextureHeight = 0;
+    glGenTextures(1, &rayTexture);
+    glGenFramebuffers(1, &rayFBO);
 
     // -----------------------------
     // Main Loop
@@ -496,10 +505,106 @@ int main()
         // Process input
         processInput(window);
 
+        // Ray trace the current view on the CPU (blocks this frame)
+        if (rayTraceRequested) {
+            rayTraceRequested = false;
+            int fbWidth, fbHeight;
+            glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+
+            RenderSettings settings;
+            settings.width = fbWidth;
+            settings.height = fbHeight;
+            settings.samplesPerPixel = 4;
+
+            const RayTracer tracer(buildCubeScene(cubePosition, lightPos, lightColor));
+            Framebuffer image;
+            const RenderStats stats = tracer.render(camera, settings, image);
+            const std::string outPath = "ImageOutput/raytrace_view.png";
+            if (writeFramebuffer(image, outPath)) {
+                std::cout << "[OK] Ray traced " << fbWidth << "x" << fbHeight << " in "
+                          << std::setprecision(3) << stats.seconds * 1000.0 << " ms ("
+                          << stats.raysPerSecond() * 1e-6 << " Mrays/s on " << stats.threads
+                          << " threads): " << outPath << "\n";
+            } else {
+                std::cerr << "Failed to write image file: " << outPath << "\n";
+            }
+        }
+
+        // Refine the live ray traced view. The cube is an instance: a gizmo drag
+        // only changes its transform and refits the instance BVH.
+        if (rayTracedView) {
+            if (!liveTracer) {
+                liveTracer = std::make_unique<RayTracer>(buildCubeScene(cubePosition, lightPos, lightColor));
+                liveSceneVersion = sceneVersion;
+                progressive.reset();
+            }
+            else if (liveSceneVersion != sceneVersion) {
+                liveTracer->setInstanceTransform(cubeInstance, glm::translate(glm::mat4(1.0f), cubePosition));
+                liveTracer->updateInstances();
+                liveSceneVersion = sceneVersion;
+                progressive.reset();
+            }
+            int fbWidth, fbHeight;
+            glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+
+            RenderSettings settings;
+            settings.width = std::max(fbWidth, 1);
+            settings.height = std::max(fbHeight, 1);
+            const int samplesBefore = progressive.samples();
+            liveStats = progressive.step(*liveTracer, camera, settings);
+
+            const Framebuffer& image = progressive.image();
+            glBindTexture(GL_TEXTURE_2D, rayTexture);
+            if (image.width != rayTextureWidth || image.height != rayTextureHeight) {
+                rayTextureWidth = image.width;
+                rayTextureHeight = image.height;
+                // RGB32F is not a required color-renderable format; RGBA32F is
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, image.width, image.height, 0, GL_RGB, GL_FLOAT, nullptr);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                glBindFramebuffer(GL_READ_FRAMEBUFFER, rayFBO);
+                glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, rayTexture, 0);
+                const GLenum fboStatus = glCheckFramebufferStatus(GL_READ_FRAMEBUFFER);
+                glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+                if (fboStatus != GL_FRAMEBUFFER_COMPLETE) {
+                    // Can't blit from it: fall back to the rasterized view
+                    std::cerr << "Ray traced view unavailable: framebuffer incomplete (0x"
+                              << std::hex << fboStatus << std::dec << ")\n";
+                    rayTracedView = false;
+                    rayTextureWidth = rayTextureHeight = 0;
+                }
+            }
+            // Converged images stay in the texture; only new samples are uploaded
+            if (rayTextureWidth > 0 && progressive.samples() != samplesBefore)
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width, image.height, GL_RGB, GL_FLOAT, image.pixels.data());
+        }
+
+        // Keep the terrain tiles around the camera streaming in
+        terrainTiles.set_focus(camera.position.x, camera.position.z);
+
         // Update window title with camera coordinates
         std::stringstream title;
         title << "Ray Tracer | Camera: X=" << std::fixed << std::setprecision(1) 
               << camera.position.x << " Y=" << camera.position.y << " Z=" << camera.position.z;
+
+        // Terrain noise under the camera (non-blocking: shows "..." while the tile loads)
+        {
+            const int tileX = terrainTiles.tile_coord(camera.position.x);
+            const int tileZ = terrainTiles.tile_coord(camera.position.z);
+            if (auto tile = terrainTiles.try_get(tileX, tileZ)) {
+                const int px = static_cast<int>(std::floor(camera.position.x * terrainPixelsPerUnit)) - tileX * terrainTiles.tile_size();
+                const int pz = static_cast<int>(std::floor(camera.position.z * terrainPixelsPerUnit)) - tileZ * terrainTiles.tile_size();
+                title << " | Noise=" << std::setprecision(3)
+                      << (*tile)(std::clamp(px, 0, tile->width() - 1), std::clamp(pz, 0, tile->height() - 1));
+            }
+            else {
+                title << " | Noise=...";
+            }
+        }
+        if (rayTracedView) {
+            title << " | RT " << progressive.samples() << " spp, "
+                  << std::setprecision(1) << liveStats.seconds * 1000.0 << " ms";
+        }
         glfwSetWindowTitle(window, title.str().c_str());
 
         // Simple gizmo hover detection (screen-space)
@@ -542,9 +647,19 @@ int main()
         }
 
         // Render
-        glClearColor(0.1f, 0.15f, 0.2f, 1.0f);
+        glClearColor(backgroundColor.r, backgroundColor.g, backgroundColor.b, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        // Ray traced view replaces the rasterized scene (image row 0 is the top: flip on blit)
+        if (rayTracedView && rayTextureWidth > 0) {
+            int fbWidth, fbHeight;
+            glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, rayFBO);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glBlitFramebuffer(0, 0, rayTextureWidth, rayTextureHeight, 0, fbHeight, fbWidth, 0, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+
         // Activate shader
         cubeShader.use();
 
@@ -559,54 +674,56 @@ int main()
         cubeShader.setVec3("viewPos", camera.position);
         cubeShader.setVec3("lightColor", lightColor);
 
-        // -----------------------------
-        // Render the Cube
-        // -----------------------------
-        glBindVertexArray(cubeVAO);
+        if (!rayTracedView) {
+            // -----------------------------
+            // Render the Cube
+            // -----------------------------
+            glBindVertexArray(cubeVAO);
         
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, cubePosition); // Use cubePosition variable
-        cubeShader.setMat4("model", model);
-        cubeShader.setVec3("objectColor", glm::vec3(0.3f, 0.7f, 0.9f)); // Cyan-ish color
+            glm::mat4 model = glm::mat4(1.0f);
+            model = glm::translate(model, cubePosition); // Use cubePosition variable
+            cubeShader.setMat4("model", model);
+            cubeShader.setVec3("objectColor", cubeColor); // Cyan-ish color
         
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+            glDrawArrays(GL_TRIANGLES, 0, cubeVertexCount);
 
-        // -----------------------------
-        // Render the Platform
-        // -----------------------------
-        glBindVertexArray(platformVAO);
+            // -----------------------------
+            // Render the Platform
+            // -----------------------------
+            glBindVertexArray(platformVAO);
         
-        model = glm::mat4(1.0f);
-        // Platform is already at y=0, no translation needed
-        cubeShader.setMat4("model", model);
-        cubeShader.setVec3("objectColor", glm::vec3(0.5f, 0.5f, 0.5f)); // Gray platform
+            model = glm::mat4(1.0f);
+            // Platform is already at y=0, no translation needed
+            cubeShader.setMat4("model", model);
+            cubeShader.setVec3("objectColor", platformColor); // Gray platform
         
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+            glDrawArrays(GL_TRIANGLES, 0, platformVertexCount);
 
-        // -----------------------------
-        // Render Coordinate Axes
-        // -----------------------------
-        {
-            lineShader.use();
-            lineShader.setMat4("view", view);
-            lineShader.setMat4("projection", projection);
+            // -----------------------------
+            // Render Coordinate Axes
+            // -----------------------------
+            {
+                lineShader.use();
+                lineShader.setMat4("view", view);
+                lineShader.setMat4("projection", projection);
             
-            glBindVertexArray(axesVAO);
-            glLineWidth(2.0f);
+                glBindVertexArray(axesVAO);
+                glLineWidth(2.0f);
             
-            // X axis - Red
-            lineShader.setVec3("lineColor", glm::vec3(1.0f, 0.0f, 0.0f));
-            glDrawArrays(GL_LINES, 0, 2);
+                // X axis - Red
+                lineShader.setVec3("lineColor", glm::vec3(1.0f, 0.0f, 0.0f));
+                glDrawArrays(GL_LINES, 0, 2);
             
-            // Y axis - Green
-            lineShader.setVec3("lineColor", glm::vec3(0.0f, 1.0f, 0.0f));
-            glDrawArrays(GL_LINES, 2, 2);
+                // Y axis - Green
+                lineShader.setVec3("lineColor", glm::vec3(0.0f, 1.0f, 0.0f));
+                glDrawArrays(GL_LINES, 2, 2);
             
-            // Z axis - Blue
-            lineShader.setVec3("lineColor", glm::vec3(0.0f, 0.0f, 1.0f));
-            glDrawArrays(GL_LINES, 4, 2);
+                // Z axis - Blue
+                lineShader.setVec3("lineColor", glm::vec3(0.0f, 0.0f, 1.0f));
+                glDrawArrays(GL_LINES, 4, 2);
             
-            glLineWidth(1.0f);
+                glLineWidth(1.0f);
+            }
         }
 
         // -----------------------------
@@ -689,6 +806,8 @@ int main()
     glDeleteBuffers(1, &axesVBO);
     glDeleteVertexArrays(1, &gizmoVAO);
     glDeleteBuffers(1, &gizmoVBO);
+    glDeleteFramebuffers(1, &rayFBO);
+    glDeleteTextures(1, &rayTexture);
 
     glfwDestroyWindow(window);
     glfwTerminate();
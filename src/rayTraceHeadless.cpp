@@ -0,0 +1,1118 @@
+// rayTraceHeadless.cpp
+// ---------------------------------------------------------
+// Headless entry point for the CPU ray tracer: no window, no
+// OpenGL context, so it runs on CPU-only render nodes.
+//
+// Usage:
+//   RayTraceHeadless [--width W] [--height H] [--spp N] [--tile N]
+//                    [--threads 1,2,4] [--reps N] [--no-shadows]
+//                    [--no-packets] [--compare] [--progressive FRAMES]
+//                    [--adaptive [THRESHOLDS]] [--reference-spp N]
+//                    [--distributed WORKERS [--listen ADDRESS] [--no-spawn]
+//                                           [--worker-threads N] [--faults]]
+//                    [--pattern [RESOLUTION]] [--texture-bench [RESOLUTION]]
+//                    [--fog] [--fog-bench]
+//                    [--camera x,y,z[,yaw,pitch[,zoom]]] [--cube x,y,z]
+//                    [--light x,y,z] [--out image.png]
+//   RayTraceHeadless --bvh-bench [MAX_TRIANGLES]
+//   RayTraceHeadless --instance-bench [INSTANCES]
+//   RayTraceHeadless --worker ADDRESS [--threads N]
+//
+// Prints rays/s and rays/s per thread for every thread count; the image
+// of the last run is written to --out (default ImageOutput/raytrace.png).
+// --compare renders with single rays and with 8-wide packets at every SIMD
+// level the CPU supports (scalar, SSE2, AVX2) to show the packet speedup,
+// and counts the pixels of each packet image that differ from the single-ray one.
+// --instance-bench scatters INSTANCES (default 256) copies of a terrain
+// patch mesh and times moving them (instance BVH refit / rebuild) against
+// rebuilding one flat BVH over the same triangles.
+// --progressive runs the GameWindow's live view loop for FRAMES frames (the
+// camera moves once halfway through) and reports samples and time per frame.
+// --adaptive renders with adaptive sampling at each error threshold and with
+// uniform sampling at 1, 2, 4, ... spp, measures every image's RMSE against a
+// --reference-spp render, and reports the time each needs to reach a target error.
+// --distributed renders the frame on 1, 2, 4, ... worker processes (the list
+// WORKERS) started on this machine, or waits for remote ones with --no-spawn,
+// and prints the scaling curve. --faults adds a run with one worker that dies
+// and one that is slow. --worker runs one worker (used by the coordinator).
+// --pattern puts a Perlin noise pattern on the platform and the cube, baked
+// into a RESOLUTION^2 texture pyramid (default 2048). --texture-bench times
+// texture lookups against evaluating the fBm per hit, in isolation and in
+// whole frames, and reports the texture's memory and hit rate.
+// --fog adds ray-marched ground fog over the platform. --fog-bench reports
+// its macro grid and the march throughput and frame time of adaptive
+// marching (empty-space skipping) against fixed steps, with their error; it
+// exits with 1 when the adaptive error exceeds a quarter of an 8-bit level.
+// --bvh-bench instead builds BVHs over Perlin terrain meshes from 10k up
+// to MAX_TRIANGLES (default 10M) and reports build time and Mrays/s.
+// ---------------------------------------------------------
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "AdaptiveRenderer.hpp"
+#include "Camera.hpp"
+#include "DistributedRender.hpp"
+#include "FogVolume.hpp"
+#include "Noise.hpp"
+#include "NoiseTexture.hpp"
+#include "ProgressiveRenderer.hpp"
+#include "RayTracer.hpp"
+#include "Scene.hpp"
+#include "SimdDispatch.hpp"
+#include "ThreadPool.hpp"
+
+namespace {
+
+// Benchmarks store their checksums here, so the timed work cannot be optimized away
+volatile float benchmarkSink = 0.0f;
+
+std::vector<float> parseFloats(const std::string& text) {
+    std::vector<float> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ','))
+        values.push_back(std::stof(item));
+    return values;
+}
+
+glm::vec3 parseVec3(const std::string& text) {
+    const std::vector<float> v = parseFloats(text);
+    if (v.size() != 3)
+        throw std::invalid_argument("expected x,y,z, got: " + text);
+    return glm::vec3(v[0], v[1], v[2]);
+}
+
+// -----------------------------
+// BVH benchmark
+// -----------------------------
+
+// Perlin terrain with roughly `targetTriangles` triangles on a 100x100 footprint
+Scene buildTerrainScene(size_t targetTriangles) {
+    const int cells = std::max(1, static_cast<int>(std::lround(std::sqrt(targetTriangles / 2.0))));
+    const int vertices = cells + 1;
+    const Noise::NoiseMap2D heights = Noise::generate_perlin_map2d(
+        vertices, vertices, vertices / 4.0f, 6, 1.0f, 0.5f, 2.0f, 0.0f, 21);
+
+    std::vector<float> samples(static_cast<size_t>(vertices) * vertices);
+    for (int z = 0; z < vertices; ++z)
+        for (int x = 0; x < vertices; ++x)
+            samples[static_cast<size_t>(z) * vertices + x] = heights(x, z);
+
+    Scene scene;
+    Material ground;
+    ground.color = platformColor;
+    scene.addHeightfield(samples, vertices, vertices, 100.0f, 20.0f, scene.addMaterial(ground));
+    scene.light.position = glm::vec3(30.0f, 60.0f, 30.0f);
+    return scene;
+}
+
+void runBvhBench(size_t maxTriangles) {
+    const int width = 1024, height = 1024;
+    std::cout << "BVH benchmark: Perlin terrain, " << width << "x" << height << " primary + shadow rays, "
+              << Noise::thread_count() << " threads, packets: " << Noise::simd_level_name(Noise::active_simd_level()) << "\n";
+    std::printf("%11s %10s %6s %8s %11s %10s %14s %14s %14s %14s\n",
+        "triangles", "nodes", "depth", "SAH", "build ms", "Mtri/s", "primary Mr/s", "shadow Mr/s", "pk prim Mr/s", "pk shad Mr/s");
+
+    Camera camera(glm::vec3(0.0f, 45.0f, 70.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, -35.0f);
+    for (size_t target = 10000; target <= maxTriangles; target *= 10) {
+        const RayTracer tracer(buildTerrainScene(target));
+        const BvhStats& bvh = tracer.bvhStats();
+        const size_t triangles = tracer.triangleCount();
+
+        // Closest-hit primary rays, then any-hit shadow rays from every hit point
+        const CameraRays cameraRays(camera, width, height);
+        std::vector<Ray> shadowRays(static_cast<size_t>(width) * height);
+        std::atomic<uint64_t> hits{0};
+        auto start = std::chrono::steady_clock::now();
+        Noise::parallel_for_tiles(width, height, 32, [&](const Noise::TileRect& tile) {
+            uint64_t tileHits = 0;
+            for (int y = tile.y0; y < tile.y1; ++y) {
+                for (int x = tile.x0; x < tile.x1; ++x) {
+                    const Ray ray = cameraRays.generate(x + 0.5f, y + 0.5f);
+                    const Hit hit = tracer.intersect(ray);
+                    Ray& shadow = shadowRays[static_cast<size_t>(y) * width + x];
+                    shadow.tMax = 0.0f;
+                    if (hit.valid()) {
+                        const glm::vec3 p = ray.origin + ray.direction * hit.t;
+                        const glm::vec3 toLight = tracer.scene().light.position - p;
+                        shadow.origin = p + tracer.hitNormal(hit) * 1e-3f;
+                        shadow.tMax = glm::length(toLight);
+                        shadow.direction = toLight / shadow.tMax;
+                        ++tileHits;
+                    }
+                }
+            }
+            hits.fetch_add(tileHits, std::memory_order_relaxed);
+        });
+        const double primarySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        Noise::parallel_for_tiles(width, height, 32, [&](const Noise::TileRect& tile) {
+            for (int y = tile.y0; y < tile.y1; ++y) {
+                for (int x = tile.x0; x < tile.x1; ++x) {
+                    const Ray& shadow = shadowRays[static_cast<size_t>(y) * width + x];
+                    if (shadow.tMax > 0.0f)
+                        (void)tracer.occluded(shadow);
+                }
+            }
+        });
+        const double shadowSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // The same rays again as 4x2 pixel packets
+        start = std::chrono::steady_clock::now();
+        Noise::parallel_for_tiles(width, height, 32, [&](const Noise::TileRect& tile) {
+            RayPacket8 packet;
+            PacketHit8 packetHit;
+            for (int y = tile.y0; y < tile.y1; y += 2) {
+                for (int x = tile.x0; x < tile.x1; x += 4) {
+                    packet.clear();
+                    for (int lane = 0; lane < packetWidth; ++lane) {
+                        const Ray ray = cameraRays.generate(x + lane % 4 + 0.5f, y + lane / 4 + 0.5f);
+                        packet.setLane(lane, ray.origin, ray.direction, ray.tMin, ray.tMax);
+                    }
+                    tracer.intersect(packet, packetHit);
+                }
+            }
+        });
+        const double primaryPacketSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        Noise::parallel_for_tiles(width, height, 32, [&](const Noise::TileRect& tile) {
+            RayPacket8 packet;
+            for (int y = tile.y0; y < tile.y1; y += 2) {
+                for (int x = tile.x0; x < tile.x1; x += 4) {
+                    packet.clear();
+                    for (int lane = 0; lane < packetWidth; ++lane) {
+                        const Ray& shadow = shadowRays[static_cast<size_t>(y + lane / 4) * width + x + lane % 4];
+                        if (shadow.tMax > 0.0f)
+                            packet.setLane(lane, shadow.origin, shadow.direction, shadow.tMin, shadow.tMax);
+                    }
+                    if (packet.active)
+                        (void)tracer.occluded(packet);
+                }
+            }
+        });
+        const double shadowPacketSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        const double primaryRays = static_cast<double>(width) * height;
+        const double shadowRayCount = static_cast<double>(hits.load());
+        std::printf("%11zu %10zu %6d %8.2f %11.1f %10.2f %14.2f %14.2f %14.2f %14.2f\n",
+            triangles, bvh.nodes, bvh.maxDepth, bvh.sahCost, bvh.buildSeconds * 1000.0,
+            triangles / bvh.buildSeconds * 1e-6,
+            primaryRays / primarySeconds * 1e-6, shadowRayCount / shadowSeconds * 1e-6,
+            primaryRays / primaryPacketSeconds * 1e-6, shadowRayCount / shadowPacketSeconds * 1e-6);
+    }
+}
+
+// -----------------------------
+// Instance benchmark
+// -----------------------------
+
+// Rendered primary + shadow Mrays/s of a 512x512 view (packets)
+double measureRender(const RayTracer& tracer, const Camera& camera) {
+    RenderSettings settings;
+    settings.width = 512;
+    settings.height = 512;
+    Framebuffer image;
+    double best = 0.0;
+    for (int r = 0; r < 3; ++r)
+        best = std::max(best, tracer.render(camera, settings, image).raysPerSecond() * 1e-6);
+    return best;
+}
+
+void runInstanceBench(int instanceCount) {
+    using Clock = std::chrono::steady_clock;
+    auto ms = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+
+    // One 4k-triangle terrain patch, scattered over a grid
+    const Scene patch = buildTerrainScene(4000);
+    const int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(instanceCount))));
+    auto placement = [&](int i, float lift) {
+        const glm::vec3 offset((i % columns - columns * 0.5f) * 110.0f, lift, (i / columns - columns * 0.5f) * 110.0f);
+        return glm::rotate(glm::translate(glm::mat4(1.0f), offset), 0.3f * static_cast<float>(i), glm::vec3(0.0f, 1.0f, 0.0f));
+    };
+
+    Scene instanced;
+    instanced.materials = patch.materials;
+    instanced.light = patch.light;
+    instanced.light.position = glm::vec3(0.0f, 500.0f, 0.0f);
+    instanced.meshes.push_back(Mesh{ patch.triangles });
+    for (int i = 0; i < instanceCount; ++i)
+        instanced.addInstance(0, placement(i, 0.0f));
+
+    // The same world as one flat triangle list
+    Scene flat;
+    flat.materials = instanced.materials;
+    flat.light = instanced.light;
+    for (const Instance& instance : instanced.instances) {
+        for (Triangle tri : patch.triangles) {
+            tri.v0 = glm::vec3(instance.transform * glm::vec4(tri.v0, 1.0f));
+            tri.v1 = glm::vec3(instance.transform * glm::vec4(tri.v1, 1.0f));
+            tri.v2 = glm::vec3(instance.transform * glm::vec4(tri.v2, 1.0f));
+            tri.normal = glm::normalize(glm::mat3(instance.transform) * tri.normal);
+            flat.triangles.push_back(tri);
+        }
+    }
+
+    auto start = Clock::now();
+    RayTracer tracer(instanced);
+    const double instancedBuild = ms(start);
+    start = Clock::now();
+    const RayTracer flatTracer(flat);
+    const double flatBuild = ms(start);
+
+    std::cout << "Instance benchmark: " << instanceCount << " instances x " << patch.triangles.size()
+              << " triangles = " << tracer.triangleCount() << " triangles, " << Noise::thread_count() << " threads\n";
+    std::printf("  %-40s %12.3f ms\n", "flat BVH build (every move)", flatBuild);
+    std::printf("  %-40s %12.3f ms\n", "two-level build (mesh once + instances)", instancedBuild);
+
+    // Move one instance / every instance, then refit; rebuild; add + remove
+    constexpr int frames = 100;
+    double moveOne = 0.0, moveAll = 0.0, rebuild = 0.0, addRemove = 0.0;
+    for (int frame = 0; frame < frames; ++frame) {
+        const float lift = 0.1f * static_cast<float>(frame + 1);
+        start = Clock::now();
+        tracer.setInstanceTransform(frame % instanceCount, placement(frame % instanceCount, lift));
+        tracer.updateInstances();
+        moveOne += ms(start);
+
+        start = Clock::now();
+        for (int i = 0; i < instanceCount; ++i)
+            tracer.setInstanceTransform(i, placement(i, lift));
+        tracer.updateInstances();
+        moveAll += ms(start);
+
+        start = Clock::now();
+        tracer.updateInstances(true);
+        rebuild += ms(start);
+
+        start = Clock::now();
+        const int added = tracer.addInstance(0, placement(frame, 50.0f));
+        tracer.updateInstances();
+        tracer.removeInstance(added);
+        tracer.updateInstances();
+        addRemove += ms(start);
+    }
+    std::printf("  %-40s %12.3f ms\n", "move 1 instance + refit", moveOne / frames);
+    std::printf("  %-40s %12.3f ms\n", "move all instances + refit", moveAll / frames);
+    std::printf("  %-40s %12.3f ms\n", "instance BVH rebuild", rebuild / frames);
+    std::printf("  %-40s %12.3f ms\n", "add + remove 1 instance", addRemove / frames);
+
+    // Put the instances back where the flat copy has them, then compare ray speed
+    for (int i = 0; i < instanceCount; ++i)
+        tracer.setInstanceTransform(i, placement(i, 0.0f));
+    tracer.updateInstances(true);
+    const Camera camera(glm::vec3(0.0f, 120.0f, 160.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, -35.0f);
+    std::printf("  %-40s %12.2f Mrays/s\n", "render, flat BVH", measureRender(flatTracer, camera));
+    std::printf("  %-40s %12.2f Mrays/s\n", "render, two-level", measureRender(tracer, camera));
+}
+
+// -----------------------------
+// Progressive accumulation
+// -----------------------------
+
+// Frames of the live view: the image refines while the camera is still, and
+// starts over when it moves (here: once, halfway through)
+Framebuffer runProgressive(const RayTracer& tracer, Camera& camera, const RenderSettings& settings, int frames) {
+    ProgressiveRenderer progressive;
+    std::cout << "Progressive: " << settings.width << "x" << settings.height << ", budget "
+              << progressive.progressive.frameBudgetSeconds * 1000.0 << " ms / frame, "
+              << Noise::thread_count() << " threads\n";
+    std::printf("%8s %10s %12s %14s\n", "frame", "spp", "frame ms", "Mrays/s");
+    for (int frame = 0; frame < frames; ++frame) {
+        if (frame == frames / 2 && frames > 1) {
+            camera.processMouseScroll(5.0f);    // Zoom in: the accumulation restarts
+            std::cout << "  (camera zoomed: accumulation restarts)\n";
+        }
+        const RenderStats stats = progressive.step(tracer, camera, settings);
+        if ((frame & (frame + 1)) == 0 || frame + 1 == frames || frame == frames / 2) {
+            std::printf("%8d %10d %12.2f %14.3f\n", frame, progressive.samples(),
+                stats.seconds * 1000.0, stats.raysPerSecond() * 1e-6);
+        }
+    }
+    return progressive.image();
+}
+
+// -----------------------------
+// Noise pattern textures
+// -----------------------------
+
+// Perlin pattern over the platform window, shared by the platform and the cube
+void addNoisePattern(Scene& scene, int resolution) {
+    NoisePattern pattern;
+    pattern.resolution = resolution;
+    pattern.featureSize = 2.5f;
+    pattern.octaves = 7;
+    pattern.seed = 7;
+    const int index = scene.addPattern(pattern);
+    for (Material& material : scene.materials) {
+        material.pattern = index;
+        material.patternColor = material.color * 0.35f;
+    }
+}
+
+// ns per lookup over `points` (one pass), baked or evaluated
+double lookupNanoseconds(const NoiseTexture& texture, const std::vector<glm::vec3>& points, bool baked, float& checksum) {
+    const auto start = std::chrono::steady_clock::now();
+    float sum = 0.0f;
+    for (const glm::vec3& p : points)
+        sum += baked ? texture.sample(glm::vec2(p), p.z) : texture.evaluate(glm::vec2(p));
+    checksum += sum;
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return seconds * 1e9 / static_cast<double>(points.size());
+}
+
+// Per-lookup cost of the baked texture vs the fBm, then whole renders of the
+// patterned scene: untextured, baked and evaluated per hit. Returns the baked image.
+Framebuffer runTextureBench(const Scene& scene, const Camera& camera, const RenderSettings& settings, int reps) {
+    const NoisePattern& pattern = scene.patterns.front();
+    const RayTracer tracer(scene);
+    const NoiseTexture& texture = tracer.noiseTextures().front();
+    const NoiseTextureStats bake = texture.stats();
+    std::printf("Noise texture: %d^2 texels, %d levels, %.1f MB, baked in %.1f ms (%u threads)\n",
+                bake.resolution, bake.levels, static_cast<double>(bake.bytes) / (1024.0 * 1024.0),
+                bake.bakeSeconds * 1000.0, Noise::thread_count());
+
+    // Coherent: a raster walk whose spacing matches the footprint (the mip it picks);
+    // scattered: random points and footprints of up to 16 texels
+    constexpr int grid = 512;
+    std::vector<glm::vec3> coherent, scattered;
+    const float spacing = pattern.extent / static_cast<float>(grid);
+    for (int y = 0; y < grid; ++y) {
+        for (int x = 0; x < grid; ++x)
+            coherent.emplace_back(pattern.origin + glm::vec2(x + 0.5f, y + 0.5f) * spacing, spacing);
+    }
+    uint32_t state = 12345u;
+    auto random = [&]() { state = state * 1664525u + 1013904223u; return static_cast<float>(state >> 8) * (1.0f / 16777216.0f); };
+    const float texel = pattern.extent / static_cast<float>(bake.resolution - 1);
+    for (size_t i = 0; i < coherent.size(); ++i)
+        scattered.emplace_back(pattern.origin + glm::vec2(random(), random()) * pattern.extent, random() * 16.0f * texel);
+
+    float checksum = 0.0f;
+    double best[3] = { 1e30, 1e30, 1e30 };
+    for (int r = 0; r < reps; ++r) {
+        best[0] = std::min(best[0], lookupNanoseconds(texture, coherent, true, checksum));
+        best[1] = std::min(best[1], lookupNanoseconds(texture, scattered, true, checksum));
+        best[2] = std::min(best[2], lookupNanoseconds(texture, coherent, false, checksum));
+    }
+    std::printf("  %-34s %10.1f ns\n", "lookup, baked, coherent", best[0]);
+    std::printf("  %-34s %10.1f ns\n", "lookup, baked, scattered", best[1]);
+    std::printf("  %-34s %10.1f ns   (%.1fx, %d octaves)\n", "fBm evaluated per lookup", best[2], best[2] / best[0],
+                pattern.octaves);
+
+    // Level 0 texels hold the fBm itself: compare at texel centers
+    float maxError = 0.0f;
+    for (int i = 0; i < 4096; ++i) {
+        const glm::vec2 p = pattern.origin + glm::floor(glm::vec2(random(), random()) * static_cast<float>(bake.resolution - 1)) * texel;
+        maxError = std::max(maxError, std::fabs(texture.sample(p, 0.0f) - texture.evaluate(p)));
+    }
+    std::printf("  %-34s %10.2e\n", "max |texel - fBm| at texel centers", maxError);
+    benchmarkSink = checksum;
+
+    // Whole frames
+    Scene plainScene = scene;
+    plainScene.patterns.clear();
+    for (Material& material : plainScene.materials)
+        material.pattern = -1;
+    const RayTracer plain(plainScene);
+    RayTracer evaluated(scene);
+    evaluated.setNoiseTexturesEnabled(false);
+
+    struct Run {
+        const char* name;
+        const RayTracer* tracer;
+        RenderStats stats;
+        Framebuffer image;
+    };
+    Run runs[] = { { "no pattern", &plain, {}, {} }, { "baked texture", &tracer, {}, {} }, { "fBm per hit", &evaluated, {}, {} } };
+    std::printf("\n%16s %10s %12s %14s\n", "shading", "ms", "Mrays/s", "ns/hit extra");
+    // Reps interleave the modes, so load changes on the machine hit all three alike
+    for (int r = 0; r < reps; ++r) {
+        for (Run& run : runs) {
+            if (run.tracer == &tracer)
+                tracer.resetNoiseTextureStats();    // Counters then hold one frame
+            const RenderStats stats = run.tracer->render(camera, settings, run.image);
+            if (r == 0 || stats.seconds < run.stats.seconds)
+                run.stats = stats;
+        }
+    }
+    // Every primary hit shades one pattern lookup
+    const NoiseTextureStats frame = tracer.noiseTextureStats();
+    for (const Run& run : runs) {
+        const double extra = run.tracer == &plain || frame.lookups == 0 ? 0.0
+            : (run.stats.seconds - runs[0].stats.seconds) * 1e9 / static_cast<double>(frame.lookups);
+        std::printf("%16s %10.1f %12.2f %14.1f\n", run.name, run.stats.seconds * 1000.0,
+                    run.stats.raysPerSecond() * 1e-6, extra);
+    }
+    std::printf("  lookups per frame %llu, texture hit rate %.1f%%\n",
+                static_cast<unsigned long long>(frame.lookups), frame.hitRate() * 100.0);
+
+    // Filtering: both 1 spp images against a supersampled fBm reference
+    RenderSettings referenceSettings = settings;
+    referenceSettings.samplesPerPixel = std::max(16, 4 * settings.samplesPerPixel);
+    Framebuffer reference;
+    evaluated.render(camera, referenceSettings, reference);
+    std::printf("  RMSE vs %d spp fBm reference: baked %.6f, fBm per hit %.6f\n",
+                referenceSettings.samplesPerPixel,
+                imageRmse(runs[1].image, reference), imageRmse(runs[2].image, reference));
+    return runs[1].image;
+}
+
+// -----------------------------
+// Noise fog
+// -----------------------------
+
+// Ground fog over the platform, up to a little above the cube's middle
+void addGroundFog(Scene& scene) {
+    NoiseFog fog;
+    fog.seed = 11;
+    scene.addFog(fog);
+}
+
+// Fog rays per second of one march mode over `rays` (single thread, no shading)
+double marchRaysPerSecond(const FogVolume& fog, const std::vector<Ray>& rays, const std::vector<float>& ends,
+                          FogMarch mode, float& checksum) {
+    const auto start = std::chrono::steady_clock::now();
+    glm::vec3 sum(0.0f);
+    for (size_t i = 0; i < rays.size(); ++i)
+        sum += fog.march(rays[i].origin, rays[i].direction, ends[i], glm::vec3(0.0f), mode);
+    checksum += sum.x + sum.y + sum.z;
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(rays.size()) / seconds;
+}
+
+// Adaptive fog error allowed against the fine reference: a quarter of an 8-bit
+// level. The macro grid margin is an estimate; without it the error is ~0.0018.
+constexpr double fogRmseLimit = 1.0 / 1024.0;
+
+// Macro grid figures, march throughput of the adaptive marcher vs fixed steps
+// on the frame's primary rays, then whole frames: no fog, fixed step and
+// adaptive. Returns the adaptive image; `accurate` is false when the adaptive
+// error exceeds fogRmseLimit.
+Framebuffer runFogBench(const Scene& scene, const Camera& camera, const RenderSettings& settings, int reps, bool& accurate) {
+    const RayTracer adaptive(scene);
+    const FogVolume& fog = adaptive.fogVolumes().front();
+    const FogStats grid = fog.stats();
+    std::printf("Fog macro grid: %dx%dx%d cells, %.1f%% empty, %.1f KB, built in %.1f ms (%u threads)\n",
+                grid.cellsX, grid.cellsY, grid.cellsZ, grid.emptyFraction * 100.0,
+                static_cast<double>(grid.bytes) / 1024.0, grid.buildSeconds * 1000.0, Noise::thread_count());
+
+    // Primary rays of every pixel, cut at the first surface; only those that cross the box
+    const CameraRays cameraRays(camera, settings.width, settings.height);
+    std::vector<Ray> rays;
+    std::vector<float> ends;
+    for (int y = 0; y < settings.height; ++y) {
+        for (int x = 0; x < settings.width; ++x) {
+            const Ray ray = cameraRays.generate(x + 0.5f, y + 0.5f);
+            const Hit hit = adaptive.intersect(ray);
+            const float tEnd = hit.valid() ? hit.t : ray.tMax;
+            float t0, t1;
+            if (fog.clip(ray.origin, ray.direction, tEnd, t0, t1)) {
+                rays.push_back(ray);
+                ends.push_back(tEnd);
+            }
+        }
+    }
+    accurate = true;
+    if (rays.empty()) {
+        std::printf("  no primary ray crosses the fog\n");
+        Framebuffer image;
+        adaptive.render(camera, settings, image);
+        return image;
+    }
+
+    float checksum = 0.0f;
+    double best[2] = { 0.0, 0.0 };
+    fog.resetStats();
+    marchRaysPerSecond(fog, rays, ends, FogMarch::FixedStep, checksum);
+    const FogStats fixedMarch = fog.stats();
+    fog.resetStats();
+    marchRaysPerSecond(fog, rays, ends, FogMarch::Adaptive, checksum);
+    const FogStats adaptiveMarch = fog.stats();
+    for (int r = 0; r < reps; ++r) {
+        best[0] = std::max(best[0], marchRaysPerSecond(fog, rays, ends, FogMarch::FixedStep, checksum));
+        best[1] = std::max(best[1], marchRaysPerSecond(fog, rays, ends, FogMarch::Adaptive, checksum));
+    }
+    benchmarkSink = checksum;
+    std::printf("  %zu primary rays cross the fog, 1 thread:\n", rays.size());
+    std::printf("%16s %12s %14s %12s\n", "march", "Mrays/s", "samples/ray", "speedup");
+    std::printf("%16s %12.3f %14.1f %12s\n", "fixed step", best[0] * 1e-6, fixedMarch.samplesPerRay(), "1.0x");
+    std::printf("%16s %12.3f %14.1f %11.1fx\n", "adaptive", best[1] * 1e-6, adaptiveMarch.samplesPerRay(),
+                best[1] / best[0]);
+    std::printf("  adaptive: %.1f cells/ray, %.1f%% of them skipped empty\n",
+                static_cast<double>(adaptiveMarch.cells) / static_cast<double>(adaptiveMarch.rays),
+                adaptiveMarch.cells > 0 ? 100.0 * static_cast<double>(adaptiveMarch.emptyCells) / static_cast<double>(adaptiveMarch.cells) : 0.0);
+
+    // Whole frames
+    Scene clearScene = scene;
+    clearScene.fogVolumes.clear();
+    const RayTracer clear(clearScene);
+    RayTracer fixed(scene);
+    fixed.setFogMarch(FogMarch::FixedStep);
+
+    struct Run {
+        const char* name;
+        const RayTracer* tracer;
+        RenderStats stats;
+        Framebuffer image;
+    };
+    Run runs[] = { { "no fog", &clear, {}, {} }, { "fixed step", &fixed, {}, {} }, { "adaptive", &adaptive, {}, {} } };
+    std::printf("\n%16s %10s %12s %14s\n", "fog", "ms", "Mrays/s", "ns/fog ray");
+    // Reps interleave the modes, so load changes on the machine hit all three alike
+    for (int r = 0; r < reps; ++r) {
+        for (Run& run : runs) {
+            run.tracer->resetFogStats();    // Counters then hold one frame
+            const RenderStats stats = run.tracer->render(camera, settings, run.image);
+            if (r == 0 || stats.seconds < run.stats.seconds)
+                run.stats = stats;
+        }
+    }
+    for (const Run& run : runs) {
+        const FogStats frame = run.tracer->fogStats();
+        const double extra = frame.rays == 0 ? 0.0
+            : (run.stats.seconds - runs[0].stats.seconds) * 1e9 / static_cast<double>(frame.rays);
+        std::printf("%16s %10.1f %12.2f %14.1f\n", run.name, run.stats.seconds * 1000.0,
+                    run.stats.raysPerSecond() * 1e-6, extra);
+    }
+
+    // Accuracy: both against fixed steps a quarter as long
+    Scene fineScene = scene;
+    for (NoiseFog& volume : fineScene.fogVolumes)
+        volume.fixedStep *= 0.25f;
+    RayTracer fine(fineScene);
+    fine.setFogMarch(FogMarch::FixedStep);
+    Framebuffer reference;
+    fine.render(camera, settings, reference);
+    const double adaptiveRmse = imageRmse(runs[2].image, reference);
+    accurate = adaptiveRmse <= fogRmseLimit;
+    std::printf("  RMSE vs fixed step / 4 reference: fixed step %.6f, adaptive %.6f (limit %.6f%s)\n",
+                imageRmse(runs[1].image, reference), adaptiveRmse, fogRmseLimit, accurate ? "" : ", EXCEEDED");
+    return runs[2].image;
+}
+
+// -----------------------------
+// Adaptive vs uniform sampling
+// -----------------------------
+
+struct ErrorRun {
+    double ms;
+    double meanSamples;
+    double rmse;
+};
+
+// Fastest run whose RMSE is at most `target` (nullptr if none gets there)
+const ErrorRun* fastestBelow(const std::vector<ErrorRun>& runs, double target) {
+    const ErrorRun* best = nullptr;
+    for (const ErrorRun& run : runs) {
+        if (run.rmse <= target && (!best || run.ms < best->ms))
+            best = &run;
+    }
+    return best;
+}
+
+// Error against a high-spp reference for uniform spp levels and adaptive
+// thresholds, then time-to-target-error for each uniform level's error.
+// Returns the adaptive image of the last (tightest) threshold.
+Framebuffer runAdaptive(const RayTracer& tracer, const Camera& camera, const RenderSettings& settings,
+                        const std::vector<float>& thresholds, int referenceSpp, const std::string& heatmapPath) {
+    std::cout << "Adaptive sampling: " << settings.width << "x" << settings.height << ", tile " << settings.tileSize
+              << ", " << Noise::thread_count() << " threads, reference " << referenceSpp << " spp\n";
+
+    // Reference with its own jitter pattern, so uniform runs do not share its samples
+    RenderSettings referenceSettings = settings;
+    referenceSettings.samplesPerPixel = referenceSpp;
+    referenceSettings.seed = settings.seed ^ 0x9E3779B9u;
+    Framebuffer reference;
+    const RenderStats referenceStats = tracer.render(camera, referenceSettings, reference);
+    std::printf("  reference: %.0f ms\n\n", referenceStats.seconds * 1000.0);
+
+    std::printf("%10s %10s %10s %12s\n", "uniform", "ms", "spp", "RMSE");
+    std::vector<ErrorRun> uniform;
+    Framebuffer image;
+    for (int spp = 1; spp <= std::max(referenceSpp / 4, 1); spp *= 2) {
+        RenderSettings uniformSettings = settings;
+        uniformSettings.samplesPerPixel = spp;
+        const RenderStats stats = tracer.render(camera, uniformSettings, image);
+        uniform.push_back({ stats.seconds * 1000.0, static_cast<double>(spp), imageRmse(image, reference) });
+        std::printf("%10d %10.1f %10d %12.6f\n", spp, uniform.back().ms, spp, uniform.back().rmse);
+    }
+
+    std::printf("\n%10s %10s %10s %12s %12s %8s %10s\n",
+                "threshold", "ms", "mean spp", "est. error", "RMSE", "rounds", "converged");
+    std::vector<ErrorRun> adaptive;
+    AdaptiveRenderer renderer;
+    for (float threshold : thresholds) {
+        AdaptiveSettings adaptiveSettings;
+        adaptiveSettings.threshold = threshold;
+        adaptiveSettings.maxSamples = std::max(referenceSpp, adaptiveSettings.minSamples);
+        const AdaptiveStats stats = renderer.render(tracer, camera, settings, adaptiveSettings);
+        adaptive.push_back({ stats.seconds * 1000.0, stats.meanSamples, imageRmse(renderer.image(), reference) });
+        std::printf("%10.5f %10.1f %10.1f %12.6f %12.6f %8d %5d/%-4d\n", threshold, adaptive.back().ms,
+                    stats.meanSamples, stats.estimatedError, adaptive.back().rmse, stats.rounds,
+                    stats.convergedTiles, stats.tiles);
+    }
+
+    std::printf("\nTime to target error (fastest run at or below the target RMSE):\n");
+    std::printf("%12s %12s %12s %10s\n", "target RMSE", "uniform ms", "adaptive ms", "speedup");
+    for (const ErrorRun& level : uniform) {
+        if (level.meanSamples < 4.0)
+            continue;   // Below minSamples: adaptive cannot compete by design
+        const ErrorRun* u = fastestBelow(uniform, level.rmse);
+        const ErrorRun* a = fastestBelow(adaptive, level.rmse);
+        if (a)
+            std::printf("%12.6f %12.1f %12.1f %9.2fx\n", level.rmse, u->ms, a->ms, u->ms / a->ms);
+        else
+            std::printf("%12.6f %12.1f %12s %10s\n", level.rmse, u->ms, "-", "-");
+    }
+
+    if (!heatmapPath.empty() && writeFramebuffer(renderer.sampleHeatmap(), heatmapPath))
+        std::cout << "[OK] Sample heat map saved at: " << heatmapPath << "\n";
+    return renderer.image();
+}
+
+// -----------------------------
+// Distributed rendering
+// -----------------------------
+
+struct DistributedOptions {
+    std::vector<int> workerCounts;
+    std::string listenAddress;      // Empty: a Unix socket in /tmp
+    bool spawn = true;              // Start the workers here (false: wait for remote ones)
+    unsigned workerThreads = 1;
+    bool faults = false;
+    std::string executable;         // This program, started again with --worker
+};
+
+size_t countMismatches(const Framebuffer& a, const Framebuffer& b) {
+    size_t mismatches = 0;
+    for (size_t i = 0; i < a.pixels.size() && i < b.pixels.size(); ++i)
+        mismatches += a.pixels[i] != b.pixels[i] ? 1 : 0;
+    return mismatches + (a.pixels.size() != b.pixels.size() ? 1 : 0);
+}
+
+// One coordinator with `count` workers: best of `reps` frames, then the workers exit.
+// `workerArgs[i]` are extra options for worker i (fault injection).
+bool runDistributedFrames(const DistributedOptions& options, const Scene& scene, const Camera& camera,
+                          const RenderSettings& settings, int count, int reps,
+                          const std::vector<std::vector<std::string>>& workerArgs,
+                          Framebuffer& image, DistributedStats& best, double& setupMs) {
+    const auto start = std::chrono::steady_clock::now();
+    LocalWorkers workers;           // Declared first: the coordinator shuts them down before they are waited for
+    RenderCoordinator coordinator;
+    const std::string address = options.listenAddress.empty()
+        ? "unix:/tmp/raytrace-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + ".sock"
+        : options.listenAddress;
+    if (!coordinator.listen(address)) {
+        std::cerr << "error: " << coordinator.error() << "\n";
+        return false;
+    }
+
+    if (options.spawn) {
+        for (int i = 0; i < count; ++i) {
+            std::vector<std::string> args = { "--worker", coordinator.address(),
+                                              "--threads", std::to_string(options.workerThreads) };
+            if (i < static_cast<int>(workerArgs.size()))
+                args.insert(args.end(), workerArgs[i].begin(), workerArgs[i].end());
+            if (!workers.spawn(options.executable, args)) {
+                std::cerr << "error: cannot start worker process " << options.executable << "\n";
+                return false;
+            }
+        }
+    }
+    else {
+        std::cout << "  waiting for " << count << " workers: RayTraceHeadless --worker " << coordinator.address() << "\n";
+    }
+    if (coordinator.acceptWorkers(count, options.spawn ? 30.0 : 600.0) < count) {
+        std::cerr << "error: only " << coordinator.workerCount() << " of " << count << " workers connected\n";
+        return false;
+    }
+    coordinator.setScene(scene);
+    setupMs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0;
+
+    for (int rep = 0; rep < reps; ++rep) {
+        const DistributedStats stats = coordinator.render(camera, settings, image);
+        if (!stats.complete) {
+            std::cerr << "error: " << coordinator.error() << "\n";
+            return false;
+        }
+        if (rep == 0 || stats.seconds < best.seconds)
+            best = stats;
+    }
+    return true;   // ~RenderCoordinator shuts the workers down, ~LocalWorkers waits for them
+}
+
+// Scaling curve over the worker counts, each image checked against a local render
+Framebuffer runDistributed(const DistributedOptions& options, const Scene& scene, const RayTracer& tracer,
+                           const Camera& camera, const RenderSettings& settings, int reps) {
+    std::vector<uint8_t> sceneBytes;
+    serializeScene(scene, sceneBytes);
+    std::cout << "Distributed: " << settings.width << "x" << settings.height << " @ " << settings.samplesPerPixel
+              << " spp, tile " << settings.tileSize << ", scene " << sceneBytes.size() << " bytes, "
+              << options.workerThreads << " thread(s) per worker\n";
+
+    // Local reference: same thread count as one worker
+    Noise::set_thread_count(options.workerThreads);
+    Framebuffer reference;
+    double localMs = 0.0;
+    for (int rep = 0; rep < reps; ++rep) {
+        const double ms = tracer.render(camera, settings, reference).seconds * 1000.0;
+        localMs = rep == 0 ? ms : std::min(localMs, ms);
+    }
+    Noise::set_thread_count(0);
+    std::printf("  local render: %.1f ms\n", localMs);
+
+    std::printf("%8s %10s %10s %9s %10s %10s %12s %10s\n",
+                "workers", "setup ms", "frame ms", "speedup", "efficiency", "Mrays/s", "tiles/worker", "mismatch");
+    Framebuffer image;
+    for (int count : options.workerCounts) {
+        DistributedStats stats;
+        double setupMs = 0.0;
+        if (!runDistributedFrames(options, scene, camera, settings, count, reps, {}, image, stats, setupMs))
+            return image;
+        const auto [low, high] = std::minmax_element(stats.tilesPerWorker.begin(), stats.tilesPerWorker.end());
+        const double speedup = localMs / (stats.seconds * 1000.0);
+        std::printf("%8d %10.1f %10.1f %8.2fx %9.0f%% %10.3f %5d-%-6d %10zu\n", count, setupMs, stats.seconds * 1000.0,
+                    speedup, 100.0 * speedup / count, stats.raysPerSecond() * 1e-6,
+                    low == stats.tilesPerWorker.end() ? 0 : *low, high == stats.tilesPerWorker.end() ? 0 : *high,
+                    countMismatches(image, reference));
+    }
+
+    if (options.faults && options.spawn) {
+        // Worker 0 drops its connection after 3 tiles, worker 1 takes 300 ms per tile
+        const int count = std::max(options.workerCounts.empty() ? 3 : options.workerCounts.back(), 3);
+        const std::vector<std::vector<std::string>> faults = {
+            { "--worker-exit-after", "3" }, { "--worker-delay", "300" } };
+        DistributedStats stats;
+        double setupMs = 0.0;
+        std::cout << "\nFaults: " << count << " workers, worker 0 dies after 3 tiles, worker 1 is slow (300 ms / tile)\n";
+        if (runDistributedFrames(options, scene, camera, settings, count, 1, faults, image, stats, setupMs)) {
+            std::printf("  frame %.1f ms, %d tiles re-queued, %d re-issued, %d late duplicates, %zu mismatched pixels\n",
+                        stats.seconds * 1000.0, stats.requeued, stats.reissued, stats.duplicates,
+                        countMismatches(image, reference));
+        }
+    }
+    return image;
+}
+
+void usage() {
+    std::cout <<
+        "RayTraceHeadless [options]\n"
+        "  --width W          image width (default 1280)\n"
+        "  --height H         image height (default 720)\n"
+        "  --spp N            samples per pixel (default 1)\n"
+        "  --tile N           screen tile edge in pixels (default 32)\n"
+        "  --threads LIST     thread counts to run, e.g. 1,2,4 (default: all hardware threads)\n"
+        "  --reps N           renders per thread count, best time is reported (default 3)\n"
+        "  --no-shadows       skip shadow rays (pure rasterizer-equivalent shading)\n"
+        "  --no-packets       trace one ray at a time instead of 8-wide SIMD packets\n"
+        "  --compare          single rays vs packets at every SIMD level: speed and differing pixels\n"
+        "  --progressive N    run N frames of progressive accumulation (GameWindow R view)\n"
+        "  --adaptive [LIST]  adaptive sampling at error thresholds (default 0.02,0.01,0.005,0.0025)\n"
+        "                     vs uniform spp: RMSE against a reference and time to a target error\n"
+        "  --reference-spp N  samples per pixel of the --adaptive reference image (default 256)\n"
+        "  --pattern [RES]    noise pattern on the platform and cube, baked at RES^2 texels (default 2048)\n"
+        "  --texture-bench [RES]  baked noise texture vs fBm per hit: lookup cost, frame time, memory\n"
+        "  --fog              ray-marched noise ground fog over the platform\n"
+        "  --fog-bench        fog macro grid, adaptive vs fixed-step marching: rays/s, frame time, error\n"
+        "  --camera x,y,z[,yaw,pitch[,zoom]]  camera (default 0,2,8,-90,0,45 as in GameWindow)\n"
+        "  --cube x,y,z       cube position (default 0,1,0)\n"
+        "  --light x,y,z      point light position (default 3,5,3)\n"
+        "  --out FILE         output image (.png/.jpg/.bmp/.tga, default ImageOutput/raytrace.png)\n"
+        "  --bvh-bench [MAX]  BVH build time and Mrays/s on 10k..MAX triangle terrains (default 10M)\n"
+        "  --instance-bench [N]  move N terrain instances (default 256): refit/rebuild vs flat BVH\n"
+        "  --distributed LIST render on LIST worker processes, e.g. 1,2,4: scaling curve\n"
+        "  --listen ADDRESS   coordinator address, tcp:PORT, tcp:HOST:PORT or unix:PATH\n"
+        "                     (default: a Unix socket in /tmp)\n"
+        "  --no-spawn         wait for remote workers instead of starting local ones\n"
+        "  --worker-threads N threads per local worker (default 1)\n"
+        "  --faults           add a run where one worker dies and one is slow\n"
+        "  --worker ADDRESS   run as a worker for the coordinator at ADDRESS\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    RenderSettings settings;
+    std::vector<unsigned> threadCounts;
+    int reps = 3;
+    glm::vec3 cameraPos(0.0f, 2.0f, 8.0f);
+    float yaw = -90.0f, pitch = 0.0f, zoom = 45.0f;
+    glm::vec3 cubePosition = defaultCubePosition;
+    glm::vec3 lightPos = defaultLightPos;
+    std::string outPath = "ImageOutput/raytrace.png";
+    size_t bvhBenchMax = 0;
+    int instanceBench = 0;
+    bool compare = false;
+    int progressiveFrames = 0;
+    std::vector<float> adaptiveThresholds;
+    DistributedOptions distributed;
+    std::string workerAddress;
+    WorkerSettings worker;
+    int referenceSpp = 256;
+    int patternResolution = 0;
+    bool textureBench = false;
+    bool fog = false;
+    bool fogBench = false;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string a = argv[i];
+            auto next = [&]() -> std::string {
+                if (i + 1 >= argc)
+                    throw std::invalid_argument("missing value for " + a);
+                return argv[++i];
+            };
+            if (a == "--width") settings.width = std::max(1, std::stoi(next()));
+            else if (a == "--height") settings.height = std::max(1, std::stoi(next()));
+            else if (a == "--spp") settings.samplesPerPixel = std::max(1, std::stoi(next()));
+            else if (a == "--tile") settings.tileSize = std::max(1, std::stoi(next()));
+            else if (a == "--reps") reps = std::max(1, std::stoi(next()));
+            else if (a == "--no-shadows") settings.shadows = false;
+            else if (a == "--no-packets") settings.packets = false;
+            else if (a == "--compare") compare = true;
+            else if (a == "--progressive") progressiveFrames = std::max(1, std::stoi(next()));
+            else if (a == "--listen") distributed.listenAddress = next();
+            else if (a == "--no-spawn") distributed.spawn = false;
+            else if (a == "--worker-threads") distributed.workerThreads = static_cast<unsigned>(std::max(1, std::stoi(next())));
+            else if (a == "--faults") distributed.faults = true;
+            else if (a == "--worker") workerAddress = next();
+            else if (a == "--worker-exit-after") worker.exitAfterTiles = std::stoi(next());
+            else if (a == "--worker-delay") worker.tileDelaySeconds = std::stod(next()) * 0.001;
+            else if (a == "--distributed") {
+                for (float n : parseFloats(next()))
+                    distributed.workerCounts.push_back(std::max(1, static_cast<int>(n)));
+            }
+            else if (a == "--reference-spp") referenceSpp = std::max(1, std::stoi(next()));
+            else if (a == "--cube") cubePosition = parseVec3(next());
+            else if (a == "--light") lightPos = parseVec3(next());
+            else if (a == "--out") outPath = next();
+            else if (a == "--threads") {
+                for (float t : parseFloats(next()))
+                    threadCounts.push_back(static_cast<unsigned>(std::max(1.0f, t)));
+            }
+            else if (a == "--camera") {
+                const std::vector<float> v = parseFloats(next());
+                if (v.size() != 3 && v.size() != 5 && v.size() != 6)
+                    throw std::invalid_argument("--camera expects x,y,z[,yaw,pitch[,zoom]]");
+                cameraPos = glm::vec3(v[0], v[1], v[2]);
+                if (v.size() >= 5) { yaw = v[3]; pitch = v[4]; }
+                if (v.size() == 6) zoom = v[5];
+            }
+            else if (a == "--bvh-bench") {
+                bvhBenchMax = 10000000;
+                if (i + 1 < argc && argv[i + 1][0] != '-')
+                    bvhBenchMax = static_cast<size_t>(std::stod(next()));
+            }
+            else if (a == "--instance-bench") {
+                instanceBench = 256;
+                if (i + 1 < argc && argv[i + 1][0] != '-')
+                    instanceBench = std::max(1, std::stoi(next()));
+            }
+            else if (a == "--adaptive") {
+                adaptiveThresholds = { 0.02f, 0.01f, 0.005f, 0.0025f };
+                if (i + 1 < argc && argv[i + 1][0] != '-')
+                    adaptiveThresholds = parseFloats(next());
+            }
+            else if (a == "--pattern" || a == "--texture-bench") {
+                textureBench = textureBench || a == "--texture-bench";
+                patternResolution = std::max(patternResolution, 2048);
+                if (i + 1 < argc && argv[i + 1][0] != '-')
+                    patternResolution = std::max(2, std::stoi(next()));
+            }
+            else if (a == "--fog") fog = true;
+            else if (a == "--fog-bench") fog = fogBench = true;
+            else if (a == "--help" || a == "-h") { usage(); return 0; }
+            else { std::cerr << "unknown option: " << a << "\n"; usage(); return 2; }
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << "\n";
+        usage();
+        return 2;
+    }
+
+    if (threadCounts.empty())
+        threadCounts.push_back(0);
+
+    if (!workerAddress.empty()) {
+        Noise::set_thread_count(threadCounts.back());
+        return runRenderWorker(workerAddress, worker);
+    }
+
+    if (bvhBenchMax > 0) {
+        for (unsigned count : threadCounts) {
+            Noise::set_thread_count(count);
+            runBvhBench(bvhBenchMax);
+        }
+        Noise::set_thread_count(0);
+        return 0;
+    }
+
+    if (instanceBench > 0) {
+        for (unsigned count : threadCounts) {
+            Noise::set_thread_count(count);
+            runInstanceBench(instanceBench);
+        }
+        Noise::set_thread_count(0);
+        return 0;
+    }
+
+    Camera camera(cameraPos, glm::vec3(0.0f, 1.0f, 0.0f), yaw, pitch);
+    camera.zoom = zoom;
+
+    Scene scene = buildCubeScene(cubePosition, lightPos, defaultLightColor);
+    if (patternResolution > 0)
+        addNoisePattern(scene, patternResolution);
+    if (fog)
+        addGroundFog(scene);
+
+    if (textureBench) {
+        Noise::set_thread_count(threadCounts.back());
+        const Framebuffer image = runTextureBench(scene, camera, settings, reps);
+        Noise::set_thread_count(0);
+        if (!writeFramebuffer(image, outPath)) {
+            std::cerr << "Failed to write image file: " << outPath << "\n";
+            return 1;
+        }
+        std::cout << "[OK] Ray traced image saved at: " << outPath << "\n";
+        return 0;
+    }
+
+    if (fogBench) {
+        Noise::set_thread_count(threadCounts.back());
+        bool accurate = true;
+        const Framebuffer image = runFogBench(scene, camera, settings, reps, accurate);
+        Noise::set_thread_count(0);
+        if (!writeFramebuffer(image, outPath)) {
+            std::cerr << "Failed to write image file: " << outPath << "\n";
+            return 1;
+        }
+        std::cout << "[OK] Ray traced image saved at: " << outPath << "\n";
+        if (!accurate) {
+            std::cerr << "Adaptive fog error exceeds the limit: the macro grid skipped fog\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    const RayTracer tracer(scene);
+    Framebuffer image;
+
+    if (progressiveFrames > 0) {
+        Noise::set_thread_count(threadCounts.back());
+        image = runProgressive(tracer, camera, settings, progressiveFrames);
+        Noise::set_thread_count(0);
+        if (!writeFramebuffer(image, outPath)) {
+            std::cerr << "Failed to write image file: " << outPath << "\n";
+            return 1;
+        }
+        std::cout << "[OK] Ray traced image saved at: " << outPath << "\n";
+        return 0;
+    }
+
+    if (!distributed.workerCounts.empty()) {
+        // Workers are this program started again
+        distributed.executable = std::filesystem::exists("/proc/self/exe")
+            ? std::filesystem::read_symlink("/proc/self/exe").string() : std::string(argv[0]);
+        image = runDistributed(distributed, scene, tracer, camera, settings, reps);
+        if (!writeFramebuffer(image, outPath)) {
+            std::cerr << "Failed to write image file: " << outPath << "\n";
+            return 1;
+        }
+        std::cout << "[OK] Ray traced image saved at: " << outPath << "\n";
+        return 0;
+    }
+
+    if (!adaptiveThresholds.empty()) {
+        Noise::set_thread_count(threadCounts.back());
+        const size_t dot = outPath.find_last_of('.');
+        const std::string heatmapPath = dot == std::string::npos
+            ? outPath + "_samples.png" : outPath.substr(0, dot) + "_samples" + outPath.substr(dot);
+        image = runAdaptive(tracer, camera, settings, adaptiveThresholds, referenceSpp, heatmapPath);
+        Noise::set_thread_count(0);
+        if (!writeFramebuffer(image, outPath)) {
+            std::cerr << "Failed to write image file: " << outPath << "\n";
+            return 1;
+        }
+        std::cout << "[OK] Ray traced image saved at: " << outPath << "\n";
+        return 0;
+    }
+
+    std::cout << "Ray tracing " << settings.width << "x" << settings.height
+              << " @ " << settings.samplesPerPixel << " spp, "
+              << tracer.triangleCount() << " triangles, tile " << settings.tileSize
+              << (settings.shadows ? ", shadows" : "") << "\n";
+    // Render modes to measure: the configured one, or single rays plus packets at every SIMD level
+    struct Mode {
+        std::string name;
+        bool packets;
+        Noise::SimdLevel simd;
+    };
+    const Noise::SimdLevel simd = Noise::active_simd_level();
+    std::vector<Mode> modes;
+    if (compare) {
+        modes.push_back({ "rays", false, simd });
+        for (Noise::SimdLevel level : { Noise::SimdLevel::Scalar, Noise::SimdLevel::SSE2, Noise::SimdLevel::AVX2 }) {
+            if (level <= Noise::detect_simd_level())
+                modes.push_back({ std::string("packet-") + Noise::simd_level_name(level), true, level });
+        }
+    }
+    else {
+        modes.push_back({ settings.packets ? std::string("packet-") + Noise::simd_level_name(simd) : "rays", settings.packets, simd });
+    }
+
+    // --compare: packets must reproduce the single-ray image exactly (differing pixels per mode)
+    std::printf("%14s %8s %10s %14s %16s %12s%s\n", "mode", "threads", "ms", "Mrays/s", "Mrays/s/thread", "rays",
+                compare ? "   mismatch" : "");
+
+    Framebuffer reference;
+    size_t totalMismatches = 0;
+    for (const Mode& mode : modes) {
+        RenderSettings modeSettings = settings;
+        modeSettings.packets = mode.packets;
+        Noise::set_simd_level(mode.simd);
+        for (unsigned count : threadCounts) {
+            Noise::set_thread_count(count);
+            RenderStats best;
+            for (int r = 0; r < reps; ++r) {
+                const RenderStats stats = tracer.render(camera, modeSettings, image);
+                if (r == 0 || stats.seconds < best.seconds)
+                    best = stats;
+            }
+            std::printf("%14s %8u %10.2f %14.3f %16.3f %12llu",
+                mode.name.c_str(), best.threads, best.seconds * 1000.0, best.raysPerSecond() * 1e-6,
+                best.raysPerSecondPerThread() * 1e-6, static_cast<unsigned long long>(best.rays()));
+            if (compare) {
+                if (reference.pixels.empty())
+                    reference = image;      // Single rays at the first thread count
+                const size_t mismatches = countMismatches(image, reference);
+                totalMismatches += mismatches;
+                std::printf(" %10zu", mismatches);
+            }
+            std::printf("\n");
+        }
+    }
+    Noise::set_simd_level(simd);
+    Noise::set_thread_count(0);
+    if (compare) {
+        std::printf("  %zu pixel(s) differ from the single-ray image%s\n", totalMismatches,
+                    totalMismatches == 0 ? " (packets are bit-identical)" : "");
+    }
+
+    if (!writeFramebuffer(image, outPath)) {
+        std::cerr << "Failed to write image file: " << outPath << "\n";
+        return 1;
+    }
+    std::cout << "[OK] Ray traced image saved at: " << outPath << "\n";
+    return 0;
+}